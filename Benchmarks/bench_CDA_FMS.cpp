@@ -0,0 +1,152 @@
+#include <benchmark/benchmark.h>
+
+// It times the kernels of CDA_FMS.cpp one by one. The program is included as it is, with its main
+// renamed, so the benchmark always measures the code that is in the repository.
+// Run with --benchmark_out=file.json --benchmark_out_format=json to keep the results (see
+// Scripts/run_benchmarks.sh). bytes_per_second counts the memory that each call reads or writes once.
+
+#define main CDA_FMS_main
+#include "../CDA_FMS.cpp"
+#undef main
+
+
+// it builds a star: node 0 is in c clauses, and each clause has K-1 other nodes that are only
+// in that clause. The links are random, as in create_graph
+void create_star(int c, int K, Tnode *&nodes, Thedge *&hedges, gsl_rng * r){
+    long N = 1 + (long) c * (K - 1);
+    init_graph(nodes, hedges, N, c);
+    long var;
+    for (long he = 0; he < c; he++){
+        hedges[he].ch_unsat = 0;
+        for (int w = 0; w < K; w++){
+            var = (w == 0) ? 0 : 1 + he * (K - 1) + w - 1;
+            hedges[he].nodes_in.push_back(var);
+            if (gsl_rng_uniform_pos(r) < 0.5){
+                hedges[he].links.push_back(1);
+                hedges[he].ch_unsat += (1 << w);
+            }else{
+                hedges[he].links.push_back(-1);
+            }
+            hedges[he].pos_n.push_back(nodes[var].nfacn);
+            nodes[var].fn_in.push_back(he);
+            nodes[var].pos_fn.push_back(w);
+            nodes[var].nfacn++;
+        }
+    }
+    for (long i = 0; i < N; i++){
+        nodes[i].nch = (long) pow(2, nodes[i].nfacn);
+    }
+    get_info_exc(nodes, hedges, N, c, K);
+}
+
+
+// everything that der_fms needs, on a random graph with M = alpha * N clauses
+typedef struct{
+    long N, M;
+    int K, nch_fn, max_c;
+    Tnode *nodes;
+    Thedge *hedges;
+    double **prob_joint, ***pu_cond, **me_sum, **pi, **rates;
+}Tsystem;
+
+
+void init_system(Tsystem &sys, long N, double alpha, int K, double eta, double p0){
+    gsl_rng * r;
+    init_ran(r, 1);
+    sys.N = N;
+    sys.M = (long) (alpha * N);
+    sys.K = K;
+    sys.nch_fn = (1 << K);
+    create_graph(sys.N, sys.M, K, sys.nodes, sys.hedges, r);
+    sys.max_c = get_max_c(sys.nodes, N);
+    get_info_exc(sys.nodes, sys.hedges, sys.N, sys.M, K);
+    table_all_rates(sys.max_c, K, eta, sys.rates);
+    init_probs(sys.prob_joint, sys.pu_cond, sys.pi, sys.me_sum, sys.M, K, sys.nch_fn, p0);
+    comp_pcond(sys.prob_joint, sys.pu_cond, sys.pi, sys.hedges, sys.M, K, sys.nch_fn);
+    gsl_rng_free(r);
+}
+
+
+// the system is built again only when N or K change. The program has no function to free the old
+// one, which is not a problem for the few sizes used here
+Tsystem &get_system(long N, int K){
+    static Tsystem sys;
+    static bool built = false;
+    if (!built || sys.N != N || sys.K != K){
+        init_system(sys, N, 4.2, K, 0.37, 0.5);
+        built = true;
+    }
+    return sys;
+}
+
+
+// args: c
+static void BM_recursive_marginal(benchmark::State &state){
+    int c = state.range(0);
+    vector <double> pu(c), fE(c + 1), fEnew(c + 1);
+    for (int i = 0; i < c; i++){
+        pu[i] = 0.05 + 0.9 * i / c;
+    }
+    for (auto _ : state){
+        fE[0] = 1;
+        recursive_marginal(pu.data(), c, 0, fE.data(), fEnew.data());
+        benchmark::DoNotOptimize(fE.data());
+    }
+    state.SetBytesProcessed(state.iterations() * (3 * c + 2) * sizeof(double));
+}
+BENCHMARK(BM_recursive_marginal)->RangeMultiplier(2)->Range(2, 32);
+
+
+// args: c, K. One call for the clause 0 of a node with c clauses
+static void BM_sum_fms(benchmark::State &state){
+    int c = state.range(0);
+    int K = state.range(1);
+    int nch_fn = (1 << K);
+    Tnode *nodes;
+    Thedge *hedges;
+    gsl_rng * r;
+    init_ran(r, 1);
+    create_star(c, K, nodes, hedges, r);
+    double **rates, **prob_joint, ***pu_cond, **me_sum, **pi;
+    table_all_rates(c, K, 0.37, rates);
+    init_probs(prob_joint, pu_cond, pi, me_sum, c, K, nch_fn, 0.5);
+    comp_pcond(prob_joint, pu_cond, pi, hedges, c, K, nch_fn);
+    for (auto _ : state){
+        sum_fms(0, 0, nodes, hedges, prob_joint[0], pu_cond, rates, nch_fn, 0.1, me_sum[0]);
+        benchmark::DoNotOptimize(me_sum[0]);
+    }
+    state.SetBytesProcessed(state.iterations() * (4 * (c - 1) + 3 * nch_fn) * sizeof(double));
+    gsl_rng_free(r);
+}
+BENCHMARK(BM_sum_fms)->ArgsProduct({{2, 4, 8, 16, 32}, {3, 4, 5}});
+
+
+// args: N, K. One call for the whole graph
+static void BM_comp_pcond(benchmark::State &state){
+    Tsystem &sys = get_system(state.range(0), state.range(1));
+    for (auto _ : state){
+        comp_pcond(sys.prob_joint, sys.pu_cond, sys.pi, sys.hedges, sys.M, sys.K, sys.nch_fn);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * sys.M);
+    state.SetBytesProcessed(state.iterations() * sys.M * (sys.nch_fn + 2 * sys.K) * sizeof(double));
+}
+BENCHMARK(BM_comp_pcond)->Args({10000, 3})->Args({10000, 4})->Unit(benchmark::kMicrosecond);
+
+
+// args: N. A full evaluation of the derivatives at alpha=4.2, K=3, with the threads of OMP_NUM_THREADS
+static void BM_der_fms(benchmark::State &state){
+    Tsystem &sys = get_system(state.range(0), 3);
+    double e_av = energy(sys.prob_joint, sys.hedges, sys.M) / sys.N;
+    for (auto _ : state){
+        der_fms(sys.nodes, sys.hedges, sys.prob_joint, sys.pu_cond, sys.rates, sys.M, sys.K, sys.nch_fn,
+                e_av, sys.me_sum);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * sys.M);
+    state.SetBytesProcessed(state.iterations() * sys.M * (2 * sys.nch_fn + 2 * sys.K) * sizeof(double));
+}
+BENCHMARK(BM_der_fms)->RangeMultiplier(10)->Range(10000, 1000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,34 @@
+#include <benchmark/benchmark.h>
+
+// It times the rate of G-WalkSAT in CDA_WalkSAT_av_rates.cpp, included with its main renamed as in
+// bench_CDA_FMS.cpp.
+
+#define main CDA_WalkSAT_av_rates_main
+#include "../CDA_WalkSAT_av_rates.cpp"
+#undef main
+
+
+// args: K. One rate for each E0 and S with E0 + S = max_c, at alpha=4.2 and pu_av=0.05
+static void BM_rate_walksat(benchmark::State &state){
+    int K = state.range(0);
+    int nch_exc = (1 << (K - 1));
+    int max_c = 30;
+    double mean_c = 4.2 * K;
+    double *poisson_probs, *poisson_sums;
+    double pneigh[2];
+    init_aux_arr(poisson_probs, poisson_sums, max_c);
+    get_all_poisson_sums(max_c, 0.05, poisson_probs, poisson_sums, mean_c);
+    double sum;
+    for (auto _ : state){
+        sum = 0;
+        for (int E0 = 1; E0 < max_c; E0++){
+            sum += rate_walksat(E0, max_c - E0, K, 0.3, 0.05, poisson_probs, poisson_sums, pneigh, nch_exc);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * (max_c - 1));
+}
+BENCHMARK(BM_rate_walksat)->DenseRange(3, 6);
+
+
+BENCHMARK_MAIN();
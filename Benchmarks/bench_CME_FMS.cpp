@@ -0,0 +1,78 @@
+#include <benchmark/benchmark.h>
+
+// It times the kernels of CME_FMS.cpp, included with its main renamed as in bench_CDA_FMS.cpp.
+
+#define main CME_FMS_main
+#include "../CME_FMS.cpp"
+#undef main
+
+
+// everything that der_fms needs, on a random graph with M = alpha * N clauses
+typedef struct{
+    long N, M;
+    int K, nch_fn, max_c;
+    Tnode *nodes;
+    Thedge *hedges;
+    double ****pcav, ***pu_cav, ****cme_sum, *pi, *me_sum, ***sums_save, **rates;
+}Tsystem;
+
+
+void init_system(Tsystem &sys, long N, double alpha, int K, double eta, double p0){
+    gsl_rng * r;
+    init_ran(r, 1);
+    sys.N = N;
+    sys.M = (long) (alpha * N);
+    sys.K = K;
+    sys.nch_fn = (1 << K);
+    create_graph(sys.N, sys.M, K, sys.nodes, sys.hedges, r);
+    sys.max_c = get_max_c(sys.nodes, N);
+    get_info_exc(sys.nodes, sys.hedges, sys.N, sys.M, K, sys.nch_fn);
+    table_all_rates(sys.max_c, K, eta, sys.rates);
+    init_probs(sys.pcav, sys.pu_cav, sys.pi, sys.cme_sum, sys.me_sum, sys.sums_save, sys.N, sys.M, K,
+               sys.nch_fn / 2, p0);
+    get_pu_cav(sys.pcav, sys.pu_cav, sys.hedges, sys.M, K);
+    gsl_rng_free(r);
+}
+
+
+// the system is built again only when N changes, and the old one is not freed
+Tsystem &get_system(long N){
+    static Tsystem sys;
+    static bool built = false;
+    if (!built || sys.N != N){
+        init_system(sys, N, 4.2, 3, 0.37, 0.5);
+        built = true;
+    }
+    return sys;
+}
+
+
+// args: N. One call for the whole graph
+static void BM_get_pu_cav(benchmark::State &state){
+    Tsystem &sys = get_system(state.range(0));
+    for (auto _ : state){
+        get_pu_cav(sys.pcav, sys.pu_cav, sys.hedges, sys.M, sys.K);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * sys.M);
+    state.SetBytesProcessed(state.iterations() * sys.M * sys.K * 4 * sizeof(double));
+}
+BENCHMARK(BM_get_pu_cav)->RangeMultiplier(10)->Range(10000, 100000)->Unit(benchmark::kMicrosecond);
+
+
+// args: N. A full evaluation of the derivatives at alpha=4.2, K=3, with the threads of OMP_NUM_THREADS
+static void BM_der_fms(benchmark::State &state){
+    Tsystem &sys = get_system(state.range(0));
+    double e_av = energy(sys.pu_cav, sys.pi, sys.hedges, sys.M) / sys.N;
+    for (auto _ : state){
+        der_fms(sys.nodes, sys.hedges, sys.pcav, sys.pu_cav, sys.pi, sys.rates, sys.N, sys.M, sys.K,
+                sys.nch_fn, e_av, sys.cme_sum, sys.me_sum, sys.sums_save);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * sys.M);
+    state.SetBytesProcessed(state.iterations() * sys.M * sys.K * (2 * sys.nch_fn + 2) * sizeof(double));
+}
+BENCHMARK(BM_der_fms)->RangeMultiplier(10)->Range(10000, 100000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+
+BENCHMARK_MAIN();
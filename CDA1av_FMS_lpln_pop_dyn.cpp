@@ -8,6 +8,13 @@
 #include <chrono>
 #include <vector>
 #include <map>
+#include <string>
+#include <sstream>
+#include <thread>
+#include <cstring>
+#include <cstdio>
+#include <stdint.h>
+#include <unistd.h>
 
 
 using namespace std;
@@ -317,62 +324,353 @@ double energy(vector <vector <double> > &prob_joint, int nch_fn){
 }
 
 
-// peforms the integration of the differential equations with the 2nd order Runge-Kutta
-// the method is implemented with adaptive step size
-void RK2_fms(double alpha, int K, int nch_fn, double eta, int max_gamma, long pop_size, gsl_rng *r,  
-             double p0, char *fileener, double tl, double tol = 1e-2, double t0 = 0, double dt0 = 0.01, 
-             double ef = 1e-6, double dt_min = 1e-7){
-    double **rates;
-    double e, error;                 
-    
+// all the information of one independent replica of the population. The replicas share
+// the table of rates and the step size of the integrator, but each one has its own
+// population and its own random number generator
+typedef struct{
     vector <vector <double> > prob_joint;
     map < pair <long, int>, vector <double> > pu_cond;
     vector < vector <double> > me_sum;
     vector < pair < vector <int>, vector <int> > > gamma_lp;
     map < pair <int, int>, vector <pair <long, int> > > vals_2_ind;
+    vector <vector <double> > k1, k2, prob_joint_1;
+    gsl_rng *r;
+    double e;
+}Treplica;
 
-    table_all_rates(max_gamma + 1, K, eta, rates);
-    
-    init_probs(prob_joint, pu_cond, me_sum, K, nch_fn, p0, 
-               max_gamma, alpha, pop_size, vals_2_ind, gamma_lp, r);
 
-    // initialize auxiliary arrays for the Runge-Kutta integration
-    vector <vector <double> > k1, k2, prob_joint_1;
-    init_RK_arr(k1, k2, prob_joint_1, prob_joint.size(), nch_fn);
+// replica rep uses the seed seed_r + rep * seed_stride_rep, so runs with different seeds below the
+// stride share no replica, and replica 0 keeps seed_r
+const unsigned long seed_stride_rep = 1000003;
+
+
+void init_replicas(vector <Treplica> &reps, int nrep, unsigned long seed_r, int K, int nch_fn, 
+                   double p0, int max_gamma, double alpha, long pop_size){
+    reps = vector <Treplica> (nrep);
+    for (int rep = 0; rep < nrep; rep++){
+        init_ran(reps[rep].r, seed_r + rep * seed_stride_rep);
+        init_probs(reps[rep].prob_joint, reps[rep].pu_cond, reps[rep].me_sum, K, nch_fn, p0, 
+                   max_gamma, alpha, pop_size, reps[rep].vals_2_ind, reps[rep].gamma_lp, reps[rep].r);
+        init_RK_arr(reps[rep].k1, reps[rep].k2, reps[rep].prob_joint_1, reps[rep].prob_joint.size(), nch_fn);
+    }
+}
+
+
+// it computes the first auxiliary step of RK2 in one replica. It returns false if some
+// probability becomes negative
+bool aux_step(Treplica &rep, double dt1, int nch_fn){
+    bool valid = true;
+    for (long pop_ind = 0; pop_ind < rep.prob_joint.size(); pop_ind++){
+        for (int ch = 0; ch < nch_fn; ch++){
+            rep.k1[pop_ind][ch] = dt1 * rep.me_sum[pop_ind][ch];
+            rep.prob_joint_1[pop_ind][ch] = rep.prob_joint[pop_ind][ch] + rep.k1[pop_ind][ch];
+            if (rep.prob_joint_1[pop_ind][ch] < 0){
+                valid = false;
+            }
+        }
+    }
+    return valid;
+}
+
+
+// mean and standard error of the energy over all the replicas
+void energy_stats(vector <Treplica> &reps, double &e_mean, double &e_err){
+    int nrep = reps.size();
+    e_mean = 0;
+    for (int rep = 0; rep < nrep; rep++){
+        e_mean += reps[rep].e;
+    }
+    e_mean /= nrep;
+
+    e_err = 0;
+    if (nrep > 1){
+        for (int rep = 0; rep < nrep; rep++){
+            e_err += (reps[rep].e - e_mean) * (reps[rep].e - e_mean);
+        }
+        e_err = sqrt(e_err / (nrep - 1) / nrep);
+    }
+}
+
+
+void print_energy(ofstream &fe, vector <Treplica> &reps, double t){
+    double e_mean, e_err;
+    energy_stats(reps, e_mean, e_err);
+    if (reps.size() > 1){
+        fe << t << "\t" << e_mean << "\t" << e_err << endl;
+    }else{
+        fe << t << "\t" << e_mean << endl;
+    }
+}
+
+
+// Checkpoints of the integration. When check_s > 0, every check_s seconds of wall time, at the
+// beginning of a step, t, dt1, dt_min, the energies and the joint probabilities of the population are
+// copied to memory. A second thread writes the copy to filecheck.tmp and renames it to filecheck, so
+// the integration does not wait for the disk and filecheck is always a complete checkpoint. A run
+// started with resume=1 builds the population again from the seed, takes the probabilities from
+// filecheck, if it exists, and writes the same output as a run that was never stopped. The random
+// numbers are only used to build the population, so their state does not need to be saved.
+// The checkpoint is removed when the run ends.
+typedef struct{
+    char magic[4];
+    int32_t version;
+    int32_t K;
+    int32_t nrep;
+    int64_t pop_size;
+    double alpha;
+    double par;     // the parameter of the algorithm
+    double tol;
+    double eps_c;
+}Tcheck_header;
+
+
+typedef struct{
+    string file;
+    Tcheck_header header;
+    double every;       // seconds between checkpoints, 0 if there are no checkpoints
+    double last;        // time of the last checkpoint
+    thread writer;      // it writes the last checkpoint
+    string bytes;       // last checkpoint, kept while the writer uses it
+    bool resumed;       // if the run goes on from a checkpoint
+    string saved;       // checkpoint read to resume
+    long pos;           // next byte to read in saved
+}Tcheck;
+
+
+double check_clock(){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
-    ofstream fe(fileener);
+
+// the checkpoint is fileener with .chk instead of .txt
+void init_check(Tcheck &ck, char *fileener, double every, int K, int nrep, long pop_size, double alpha,
+                double par, double tol, double eps_c){
+    ck.file = fileener;
+    if (ck.file.size() > 4 && ck.file.compare(ck.file.size() - 4, 4, ".txt") == 0){
+        ck.file.resize(ck.file.size() - 4);
+    }
+    ck.file += ".chk";
+    memset(&ck.header, 0, sizeof(Tcheck_header));
+    memcpy(ck.header.magic, "AMEP", 4);
+    ck.header.version = 2;
+    ck.header.K = K;
+    ck.header.nrep = nrep;
+    ck.header.pop_size = pop_size;
+    ck.header.alpha = alpha;
+    ck.header.par = par;
+    ck.header.tol = tol;
+    ck.header.eps_c = eps_c;
+    ck.every = every;
+    ck.last = check_clock();
+    ck.resumed = false;
+    ck.pos = 0;
+}
+
+
+// it reads the checkpoint to resume from. If there is no file, the run starts from t0. It returns
+// false if the file was written by a run with other parameters
+bool read_check(Tcheck &ck){
+    ifstream fc(ck.file.c_str(), ios::binary);
+    if (!fc.is_open()){
+        return true;
+    }
+    ostringstream all;
+    all << fc.rdbuf();
+    ck.saved = all.str();
+    ck.resumed = true;
+    if (ck.saved.size() < sizeof(Tcheck_header) ||
+        memcmp(ck.saved.data(), &ck.header, sizeof(Tcheck_header)) != 0){
+        return false;
+    }
+    ck.pos = sizeof(Tcheck_header);
+    return true;
+}
+
+
+void put_check(string &bytes, const void *p, long n){
+    bytes.append((const char *) p, n);
+}
+
+
+bool get_check(Tcheck &ck, void *p, long n){
+    if (ck.pos + n > (long) ck.saved.size()){
+        return false;
+    }
+    memcpy(p, ck.saved.data() + ck.pos, n);
+    ck.pos += n;
+    return true;
+}
+
+
+bool check_due(Tcheck &ck){
+    return ck.every > 0 && check_clock() - ck.last >= ck.every;
+}
+
+
+void write_check_file(string file, string *bytes){
+    string filetmp = file + ".tmp";
+    ofstream fc(filetmp.c_str(), ios::binary);
+    fc.write(bytes->data(), bytes->size());
+    fc.close();
+    if (!fc.fail()){
+        rename(filetmp.c_str(), file.c_str());
+    }
+}
+
+
+// it gives the new checkpoint to the writer, once it finished with the previous one
+void start_check(Tcheck &ck, string &bytes){
+    if (ck.writer.joinable()){
+        ck.writer.join();
+    }
+    ck.bytes.swap(bytes);
+    ck.writer = thread(write_check_file, ck.file, &ck.bytes);
+    ck.last = check_clock();
+}
+
+
+void wait_check(Tcheck &ck){
+    if (ck.writer.joinable()){
+        ck.writer.join();
+    }
+    ck.bytes.clear();
+}
+
+
+// it is called when the output of the run is complete
+void end_check(Tcheck &ck){
+    wait_check(ck);
+    if (ck.every > 0 || ck.resumed){
+        remove(ck.file.c_str());
+    }
+}
+
+
+// the file of the energy is flushed, and resuming cuts it at its length at the checkpoint
+void put_text_state(string &bytes, ofstream &fe){
+    fe.flush();
+    int64_t ntext = fe.tellp();
+    put_check(bytes, &ntext, sizeof(int64_t));
+}
+
+
+bool get_text_state(Tcheck &ck, ofstream &fe, char *fileener){
+    int64_t ntext;
+    if (!get_check(ck, &ntext, sizeof(int64_t)) || truncate(fileener, ntext) != 0){
+        return false;
+    }
+    fe.open(fileener, ios::app);
+    return fe.is_open();
+}
+
+
+// it copies the state of the integration to a new checkpoint, see Tcheck
+void save_check(Tcheck &ck, ofstream &fe, double t, double dt1, double dt_min, vector <Treplica> &reps, 
+                int nch_fn){
+    string bytes;
+    put_check(bytes, &ck.header, sizeof(Tcheck_header));
+    double scalars[3] = {t, dt1, dt_min};
+    put_check(bytes, scalars, sizeof(scalars));
+    put_text_state(bytes, fe);
+    for (int rep = 0; rep < reps.size(); rep++){
+        put_check(bytes, &reps[rep].e, sizeof(double));
+        for (long pop_ind = 0; pop_ind < reps[rep].prob_joint.size(); pop_ind++){
+            put_check(bytes, reps[rep].prob_joint[pop_ind].data(), nch_fn * sizeof(double));
+        }
+    }
+    start_check(ck, bytes);
+}
+
+
+bool load_check(Tcheck &ck, char *fileener, ofstream &fe, double &t, double &dt1, double &dt_min, 
+                vector <Treplica> &reps, int nch_fn){
+    double scalars[3];
+    if (!get_check(ck, scalars, sizeof(scalars)) || !get_text_state(ck, fe, fileener)){
+        return false;
+    }
+    t = scalars[0];
+    dt1 = scalars[1];
+    dt_min = scalars[2];
+    for (int rep = 0; rep < reps.size(); rep++){
+        if (!get_check(ck, &reps[rep].e, sizeof(double))){
+            return false;
+        }
+        for (long pop_ind = 0; pop_ind < reps[rep].prob_joint.size(); pop_ind++){
+            if (!get_check(ck, reps[rep].prob_joint[pop_ind].data(), nch_fn * sizeof(double))){
+                return false;
+            }
+        }
+    }
+    bool complete = (ck.pos == ck.saved.size());
+    string().swap(ck.saved);
+    return complete;
+}
+
+
+// peforms the integration of the differential equations with the 2nd order Runge-Kutta
+// the method is implemented with adaptive step size
+// nrep independent replicas of the population are integrated with a common step size.
+// A step is accepted only if it is valid for all of them, and the error is averaged over
+// all the replicas. It returns false if the checkpoint to resume from cannot be read
+bool RK2_fms(double alpha, int K, int nch_fn, double eta, int max_gamma, long pop_size, 
+             unsigned long seed_r, int nrep, double p0, char *fileener, double tl, Tcheck &ck, double tol = 1e-2, 
+             double t0 = 0, double dt0 = 0.01, double ef = 1e-6, double dt_min = 1e-7){
+    double **rates;
+    double e_mean, e_err, error;
+    long ntot;
+
+    vector <Treplica> reps;
+
+    table_all_rates(max_gamma + 1, K, eta, rates);
     
-    e = energy(prob_joint, nch_fn) * alpha;
-    fe << t0 << "\t" << e << endl;   // it prints the energy density
+    init_replicas(reps, nrep, seed_r, K, nch_fn, p0, max_gamma, alpha, pop_size);
+
+    ntot = 0;
+    for (int rep = 0; rep < nrep; rep++){
+        ntot += reps[rep].prob_joint.size();
+    }
 
+    ofstream fe;
     double dt1 = dt0;
     double t = t0;
 
+    if (ck.resumed){
+        if (!load_check(ck, fileener, fe, t, dt1, dt_min, reps, nch_fn)){
+            return false;
+        }
+    }else{
+        fe.open(fileener);
+        for (int rep = 0; rep < nrep; rep++){
+            reps[rep].e = energy(reps[rep].prob_joint, nch_fn) * alpha;
+        }
+        print_energy(fe, reps, t0);   // it prints the energy density
+    }
+
     bool valid;
 
     // the time scale is already given in Monte Carlo steps. Inside the rates I am using 
     // the energy density e_av
     while (t < tl){
-        if (e < ef){
+        energy_stats(reps, e_mean, e_err);
+        if (e_mean < ef){
             //  cout << "Final energy reached" << endl;
             break;
         }
 
+        if (check_due(ck)){
+            save_check(ck, fe, t, dt1, dt_min, reps, nch_fn);
+        }
+
         auto t1 = std::chrono::high_resolution_clock::now();
 
-        comp_pcond(prob_joint, pu_cond, K, nch_fn, vals_2_ind);
+        valid = true;
+        for (int rep = 0; rep < nrep; rep++){
+            comp_pcond(reps[rep].prob_joint, reps[rep].pu_cond, K, nch_fn, reps[rep].vals_2_ind);
 
-        der_fms(prob_joint, pu_cond, rates, K, nch_fn, e, me_sum, gamma_lp, vals_2_ind);   // in the rates, I use the energy density
+            der_fms(reps[rep].prob_joint, reps[rep].pu_cond, rates, K, nch_fn, reps[rep].e, 
+                    reps[rep].me_sum, reps[rep].gamma_lp, reps[rep].vals_2_ind);   // in the rates, I use the energy density
 
-        valid = true;
-        for (long pop_ind = 0; pop_ind < prob_joint.size(); pop_ind++){
-            for (int ch = 0; ch < nch_fn; ch++){
-                k1[pop_ind][ch] = dt1 * me_sum[pop_ind][ch];
-                prob_joint_1[pop_ind][ch] = prob_joint[pop_ind][ch] + k1[pop_ind][ch];
-                if (prob_joint_1[pop_ind][ch] < 0){
-                    valid = false;
-                }
-            }
+            valid = aux_step(reps[rep], dt1, nch_fn) && valid;
         }
 
         while (!valid){
@@ -385,28 +683,25 @@ void RK2_fms(double alpha, int K, int nch_fn, double eta, int max_gamma, long po
             }
 
             valid = true;
-            for (long pop_ind = 0; pop_ind < prob_joint.size(); pop_ind++){
-                for (int ch = 0; ch < nch_fn; ch++){
-                    k1[pop_ind][ch] = dt1 * me_sum[pop_ind][ch];
-                    prob_joint_1[pop_ind][ch] = prob_joint[pop_ind][ch] + k1[pop_ind][ch];
-                    if (prob_joint_1[pop_ind][ch] < 0){
-                        valid = false;
-                    }
-                }
+            for (int rep = 0; rep < nrep; rep++){
+                valid = aux_step(reps[rep], dt1, nch_fn) && valid;
             }
         }
         
-        e = energy(prob_joint_1, nch_fn) * alpha;
-        comp_pcond(prob_joint_1, pu_cond, K, nch_fn, vals_2_ind);
+        valid = true;
+        for (int rep = 0; rep < nrep; rep++){
+            Treplica &rp = reps[rep];
+            rp.e = energy(rp.prob_joint_1, nch_fn) * alpha;
+            comp_pcond(rp.prob_joint_1, rp.pu_cond, K, nch_fn, rp.vals_2_ind);
 
-        der_fms(prob_joint_1, pu_cond, rates, K, nch_fn, e, me_sum, gamma_lp, vals_2_ind);
+            der_fms(rp.prob_joint_1, rp.pu_cond, rates, K, nch_fn, rp.e, rp.me_sum, rp.gamma_lp, rp.vals_2_ind);
             
-        valid = true;
-        for (long pop_ind = 0; pop_ind < prob_joint.size(); pop_ind++){
-            for (int ch = 0; ch < nch_fn; ch++){
-                k2[pop_ind][ch] = dt1 * me_sum[pop_ind][ch];
-                if (prob_joint[pop_ind][ch] + (k1[pop_ind][ch] + k2[pop_ind][ch]) / 2 < 0){
-                    valid = false;
+            for (long pop_ind = 0; pop_ind < rp.prob_joint.size(); pop_ind++){
+                for (int ch = 0; ch < nch_fn; ch++){
+                    rp.k2[pop_ind][ch] = dt1 * rp.me_sum[pop_ind][ch];
+                    if (rp.prob_joint[pop_ind][ch] + (rp.k1[pop_ind][ch] + rp.k2[pop_ind][ch]) / 2 < 0){
+                        valid = false;
+                    }
                 }
             }
         }
@@ -419,31 +714,40 @@ void RK2_fms(double alpha, int K, int nch_fn, double eta, int max_gamma, long po
                 dt_min /= 2;
                 //  cout << "dt_min also halfed" << endl;
             }
-            e = energy(prob_joint, nch_fn) * alpha;
+            for (int rep = 0; rep < nrep; rep++){
+                reps[rep].e = energy(reps[rep].prob_joint, nch_fn) * alpha;
+            }
         }else{
             error = 0;
-            for (long pop_ind = 0; pop_ind < prob_joint.size(); pop_ind++){
-                for (int ch = 0; ch < nch_fn; ch++){
-                    error += fabs(k1[pop_ind][ch] - k2[pop_ind][ch]);
+            for (int rep = 0; rep < nrep; rep++){
+                for (long pop_ind = 0; pop_ind < reps[rep].prob_joint.size(); pop_ind++){
+                    for (int ch = 0; ch < nch_fn; ch++){
+                        error += fabs(reps[rep].k1[pop_ind][ch] - reps[rep].k2[pop_ind][ch]);
+                    }
                 }
             }
 
-            error /= nch_fn * prob_joint.size();
+            error /= nch_fn * ntot;
 
             if (error < 2 * tol){
                 //  cout << "step dt=" << dt1 << "  accepted" << endl;
                 //  cout << "error=" << error << endl;
                 t += dt1;
-                for (long pop_ind = 0; pop_ind < prob_joint.size(); pop_ind++){
-                    for (int ch = 0; ch < nch_fn; ch++){
-                        prob_joint[pop_ind][ch] += (k1[pop_ind][ch] + k2[pop_ind][ch]) / 2;
+                for (int rep = 0; rep < nrep; rep++){
+                    Treplica &rp = reps[rep];
+                    for (long pop_ind = 0; pop_ind < rp.prob_joint.size(); pop_ind++){
+                        for (int ch = 0; ch < nch_fn; ch++){
+                            rp.prob_joint[pop_ind][ch] += (rp.k1[pop_ind][ch] + rp.k2[pop_ind][ch]) / 2;
+                        }
                     }
+                    rp.e = energy(rp.prob_joint, nch_fn) * alpha;
                 }
-                e = energy(prob_joint, nch_fn) * alpha;
-                fe << t << "\t" << e << endl;
+                print_energy(fe, reps, t);
 
             }else{
-                e = energy(prob_joint, nch_fn) * alpha;
+                for (int rep = 0; rep < nrep; rep++){
+                    reps[rep].e = energy(reps[rep].prob_joint, nch_fn) * alpha;
+                }
                 //  cout << "step dt=" << dt1 << "  rejected  new step will be attempted" << endl;
                 //  cout << "error=" <<  error << endl;
             }
@@ -463,8 +767,9 @@ void RK2_fms(double alpha, int K, int nch_fn, double eta, int max_gamma, long po
         cout << endl << "iteration time:   " << ms_int.count() << "ms" << endl; 
     }
 
+    wait_check(ck);
     fe.close();
-
+    return true;
 }
 
 
@@ -478,23 +783,47 @@ int main(int argc, char *argv[]) {
     double tol = atof(argv[7]);
     int nthr = atoi(argv[8]);
     double eps_c = atof(argv[9]);
+    int nrep = 1;
+    if (argc > 10){
+        nrep = atoi(argv[10]);
+    }
+    double check_s = 0;     // wall seconds between checkpoints, 0 writes none (see Tcheck)
+    if (argc > 11){
+        check_s = atof(argv[11]);
+    }
+    bool resume = false;
+    if (argc > 12){
+        resume = (atoi(argv[12]) != 0);
+    }
 
     int nch_fn = (1 << K);
     double p0 = 0.5;
 
-    gsl_rng * r;
-    init_ran(r, seed_r);
-
     omp_set_num_threads(nthr);
 
     char fileener[300]; 
-    sprintf(fileener, "CDA1av_lpln_popdyn_FMS_ener_K_%d_alpha_%.4lf_eta_%.4lf_tl_%.2lf_tol_%.1e_epsc_%.e_popsize_%li_seed_%li.txt", 
-            K, alpha, eta, tl, tol, eps_c, pop_size, seed_r);
+    if (nrep > 1){
+        sprintf(fileener, "CDA1av_lpln_popdyn_FMS_ener_K_%d_alpha_%.4lf_eta_%.4lf_tl_%.2lf_tol_%.1e_epsc_%.e_popsize_%li_seed_%li_nrep_%d.txt", 
+                K, alpha, eta, tl, tol, eps_c, pop_size, seed_r, nrep);
+    }else{
+        sprintf(fileener, "CDA1av_lpln_popdyn_FMS_ener_K_%d_alpha_%.4lf_eta_%.4lf_tl_%.2lf_tol_%.1e_epsc_%.e_popsize_%li_seed_%li.txt", 
+                K, alpha, eta, tl, tol, eps_c, pop_size, seed_r);
+    }
 
 
     int max_gamma = get_max_gamma(alpha, K, eps_c);
     
-    RK2_fms(alpha, K, nch_fn, eta, max_gamma, pop_size, r, p0, fileener, tl, tol);
+    Tcheck check;
+    init_check(check, fileener, check_s, K, nrep, pop_size, alpha, eta, tol, eps_c);
+    if (resume && !read_check(check)){
+        cout << "The checkpoint " << check.file << " is not from a run with these parameters" << endl;
+        return 1;
+    }
+    if (!RK2_fms(alpha, K, nch_fn, eta, max_gamma, pop_size, seed_r, nrep, p0, fileener, tl, check, tol)){
+        cout << "Cannot resume from the checkpoint " << check.file << endl;
+        return 1;
+    }
+    end_check(check);
     
 
     
@@ -8,6 +8,13 @@
 #include <chrono>
 #include <vector>
 #include <map>
+#include <string>
+#include <sstream>
+#include <thread>
+#include <cstring>
+#include <cstdio>
+#include <stdint.h>
+#include <unistd.h>
 
 
 using namespace std;
@@ -354,10 +361,209 @@ double energy(vector <vector <double> > &prob_joint, int nch_fn){
 }
 
 
+// Checkpoints of the integration. When check_s > 0, every check_s seconds of wall time, at the
+// beginning of a step, t, dt1, dt_min, the energies and the joint probabilities of the population are
+// copied to memory. A second thread writes the copy to filecheck.tmp and renames it to filecheck, so
+// the integration does not wait for the disk and filecheck is always a complete checkpoint. A run
+// started with resume=1 builds the population again from the seed, takes the probabilities from
+// filecheck, if it exists, and writes the same output as a run that was never stopped. The random
+// numbers are only used to build the population, so their state does not need to be saved.
+// The checkpoint is removed when the run ends.
+typedef struct{
+    char magic[4];
+    int32_t version;
+    int32_t K;
+    int32_t nrep;
+    int64_t pop_size;
+    double alpha;
+    double par;     // the parameter of the algorithm
+    double tol;
+    double eps_c;
+}Tcheck_header;
+
+
+typedef struct{
+    string file;
+    Tcheck_header header;
+    double every;       // seconds between checkpoints, 0 if there are no checkpoints
+    double last;        // time of the last checkpoint
+    thread writer;      // it writes the last checkpoint
+    string bytes;       // last checkpoint, kept while the writer uses it
+    bool resumed;       // if the run goes on from a checkpoint
+    string saved;       // checkpoint read to resume
+    long pos;           // next byte to read in saved
+}Tcheck;
+
+
+double check_clock(){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+// the checkpoint is fileener with .chk instead of .txt
+void init_check(Tcheck &ck, char *fileener, double every, int K, int nrep, long pop_size, double alpha,
+                double par, double tol, double eps_c){
+    ck.file = fileener;
+    if (ck.file.size() > 4 && ck.file.compare(ck.file.size() - 4, 4, ".txt") == 0){
+        ck.file.resize(ck.file.size() - 4);
+    }
+    ck.file += ".chk";
+    memset(&ck.header, 0, sizeof(Tcheck_header));
+    memcpy(ck.header.magic, "AMEP", 4);
+    ck.header.version = 1;
+    ck.header.K = K;
+    ck.header.nrep = nrep;
+    ck.header.pop_size = pop_size;
+    ck.header.alpha = alpha;
+    ck.header.par = par;
+    ck.header.tol = tol;
+    ck.header.eps_c = eps_c;
+    ck.every = every;
+    ck.last = check_clock();
+    ck.resumed = false;
+    ck.pos = 0;
+}
+
+
+// it reads the checkpoint to resume from. If there is no file, the run starts from t0. It returns
+// false if the file was written by a run with other parameters
+bool read_check(Tcheck &ck){
+    ifstream fc(ck.file.c_str(), ios::binary);
+    if (!fc.is_open()){
+        return true;
+    }
+    ostringstream all;
+    all << fc.rdbuf();
+    ck.saved = all.str();
+    ck.resumed = true;
+    if (ck.saved.size() < sizeof(Tcheck_header) ||
+        memcmp(ck.saved.data(), &ck.header, sizeof(Tcheck_header)) != 0){
+        return false;
+    }
+    ck.pos = sizeof(Tcheck_header);
+    return true;
+}
+
+
+void put_check(string &bytes, const void *p, long n){
+    bytes.append((const char *) p, n);
+}
+
+
+bool get_check(Tcheck &ck, void *p, long n){
+    if (ck.pos + n > (long) ck.saved.size()){
+        return false;
+    }
+    memcpy(p, ck.saved.data() + ck.pos, n);
+    ck.pos += n;
+    return true;
+}
+
+
+bool check_due(Tcheck &ck){
+    return ck.every > 0 && check_clock() - ck.last >= ck.every;
+}
+
+
+void write_check_file(string file, string *bytes){
+    string filetmp = file + ".tmp";
+    ofstream fc(filetmp.c_str(), ios::binary);
+    fc.write(bytes->data(), bytes->size());
+    fc.close();
+    if (!fc.fail()){
+        rename(filetmp.c_str(), file.c_str());
+    }
+}
+
+
+// it gives the new checkpoint to the writer, once it finished with the previous one
+void start_check(Tcheck &ck, string &bytes){
+    if (ck.writer.joinable()){
+        ck.writer.join();
+    }
+    ck.bytes.swap(bytes);
+    ck.writer = thread(write_check_file, ck.file, &ck.bytes);
+    ck.last = check_clock();
+}
+
+
+void wait_check(Tcheck &ck){
+    if (ck.writer.joinable()){
+        ck.writer.join();
+    }
+    ck.bytes.clear();
+}
+
+
+// it is called when the output of the run is complete
+void end_check(Tcheck &ck){
+    wait_check(ck);
+    if (ck.every > 0 || ck.resumed){
+        remove(ck.file.c_str());
+    }
+}
+
+
+// the file of the energy is flushed, and resuming cuts it at its length at the checkpoint
+void put_text_state(string &bytes, ofstream &fe){
+    fe.flush();
+    int64_t ntext = fe.tellp();
+    put_check(bytes, &ntext, sizeof(int64_t));
+}
+
+
+bool get_text_state(Tcheck &ck, ofstream &fe, char *fileener){
+    int64_t ntext;
+    if (!get_check(ck, &ntext, sizeof(int64_t)) || truncate(fileener, ntext) != 0){
+        return false;
+    }
+    fe.open(fileener, ios::app);
+    return fe.is_open();
+}
+
+
+// it copies the state of the integration to a new checkpoint, see Tcheck
+void save_check(Tcheck &ck, ofstream &fe, double t, double dt1, double dt_min, double e, double pu_av,
+                vector <vector <double> > &prob_joint, int nch_fn){
+    string bytes;
+    put_check(bytes, &ck.header, sizeof(Tcheck_header));
+    double scalars[5] = {t, dt1, dt_min, e, pu_av};
+    put_check(bytes, scalars, sizeof(scalars));
+    put_text_state(bytes, fe);
+    for (long pop_ind = 0; pop_ind < prob_joint.size(); pop_ind++){
+        put_check(bytes, prob_joint[pop_ind].data(), nch_fn * sizeof(double));
+    }
+    start_check(ck, bytes);
+}
+
+
+bool load_check(Tcheck &ck, char *fileener, ofstream &fe, double &t, double &dt1, double &dt_min, 
+                double &e, double &pu_av, vector <vector <double> > &prob_joint, int nch_fn){
+    double scalars[5];
+    if (!get_check(ck, scalars, sizeof(scalars)) || !get_text_state(ck, fe, fileener)){
+        return false;
+    }
+    t = scalars[0];
+    dt1 = scalars[1];
+    dt_min = scalars[2];
+    e = scalars[3];
+    pu_av = scalars[4];
+    for (long pop_ind = 0; pop_ind < prob_joint.size(); pop_ind++){
+        if (!get_check(ck, prob_joint[pop_ind].data(), nch_fn * sizeof(double))){
+            return false;
+        }
+    }
+    bool complete = (ck.pos == ck.saved.size());
+    string().swap(ck.saved);
+    return complete;
+}
+
+
 // peforms the integration of the differential equations with the 2nd order Runge-Kutta
 // the method is implemented with adaptive step size
-void RK2_walksat(double alpha, int K, int nch_fn, double q, int max_gamma, long pop_size, gsl_rng *r,  
-             double p0, char *fileener, double tl, double tol = 1e-2, double t0 = 0, double dt0 = 0.01, 
+// It returns false if the checkpoint to resume from cannot be read
+bool RK2_walksat(double alpha, int K, int nch_fn, double q, int max_gamma, long pop_size, gsl_rng *r,  
+             double p0, char *fileener, double tl, Tcheck &ck, double tol = 1e-2, double t0 = 0, double dt0 = 0.01, 
              double ef = 1e-6, double dt_min = 1e-7){
     double *poisson_probs, *poisson_sums;
     double **rates;
@@ -378,15 +584,21 @@ void RK2_walksat(double alpha, int K, int nch_fn, double q, int max_gamma, long
     vector <vector <double> > k1, k2, prob_joint_1;
     init_RK_arr(k1, k2, prob_joint_1, prob_joint.size(), nch_fn);
 
-    ofstream fe(fileener);
-    
-    pu_av = energy(prob_joint, nch_fn);
-    e = pu_av * alpha;
-    fe << t0 << "\t" << e << endl;   // it prints the energy density
-
+    ofstream fe;
     double dt1 = dt0;
     double t = t0;
 
+    if (ck.resumed){
+        if (!load_check(ck, fileener, fe, t, dt1, dt_min, e, pu_av, prob_joint, nch_fn)){
+            return false;
+        }
+    }else{
+        fe.open(fileener);
+        pu_av = energy(prob_joint, nch_fn);
+        e = pu_av * alpha;
+        fe << t0 << "\t" << e << endl;   // it prints the energy density
+    }
+
     bool valid;
 
     // the time scale is already given in Monte Carlo steps. Inside the rates I am using 
@@ -397,6 +609,10 @@ void RK2_walksat(double alpha, int K, int nch_fn, double q, int max_gamma, long
             break;
         }
 
+        if (check_due(ck)){
+            save_check(ck, fe, t, dt1, dt_min, e, pu_av, prob_joint, nch_fn);
+        }
+
         auto t1 = std::chrono::high_resolution_clock::now();
 
         comp_pcond(prob_joint, pu_cond, K, nch_fn, vals_2_ind);
@@ -510,8 +726,9 @@ void RK2_walksat(double alpha, int K, int nch_fn, double q, int max_gamma, long
         cout << endl << "iteration time:   " << ms_int.count() << "ms" << endl; 
     }
 
+    wait_check(ck);
     fe.close();
-
+    return true;
 }
 
 
@@ -525,6 +742,14 @@ int main(int argc, char *argv[]) {
     double tol = atof(argv[7]);
     int nthr = atoi(argv[8]);
     double eps_c = atof(argv[9]);
+    double check_s = 0;     // wall seconds between checkpoints, 0 writes none (see Tcheck)
+    if (argc > 10){
+        check_s = atof(argv[10]);
+    }
+    bool resume = false;
+    if (argc > 11){
+        resume = (atoi(argv[11]) != 0);
+    }
 
     int nch_fn = (1 << K);
     double p0 = 0.5;
@@ -541,7 +766,17 @@ int main(int argc, char *argv[]) {
 
     int max_gamma = get_max_gamma(alpha, K, eps_c);
     
-    RK2_walksat(alpha, K, nch_fn, q, max_gamma, pop_size, r, p0, fileener, tl, tol);
+    Tcheck check;
+    init_check(check, fileener, check_s, K, 1, pop_size, alpha, q, tol, eps_c);
+    if (resume && !read_check(check)){
+        cout << "The checkpoint " << check.file << " is not from a run with these parameters" << endl;
+        return 1;
+    }
+    if (!RK2_walksat(alpha, K, nch_fn, q, max_gamma, pop_size, r, p0, fileener, tl, check, tol)){
+        cout << "Cannot resume from the checkpoint " << check.file << endl;
+        return 1;
+    }
+    end_check(check);
     
 
     
@@ -7,6 +7,16 @@
 #include <cmath>
 #include <omp.h>
 #include <chrono>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <sstream>
+#include <thread>
 
 using namespace std;
     
@@ -37,6 +47,7 @@ typedef struct{
     double pi;          // probability of the node being 0;
     bool fixed;         // if the node has been decimated
     int dec_value;     // value of the node after decimation
+    bool dirty;         // if pi changed since the last update of the heap
 }Tnode;
 
 
@@ -47,9 +58,28 @@ typedef struct{
     vector <int> pos_n;   // position in each node's list of factor nodes.
     long **nodes_exc;   // remaining nodes after one removes a specific node from the factor node.
     vector <int> pos_not_fixed;  // indexes of the nodes that have not been decimated
+    long pos_live;      // position in the list of live factor nodes (-1 if it was removed)
 }Thedge;
 
 
+// factor nodes that still take part in the integration. A factor node is removed when it is 
+// satisfied by a decimated node, or when all its nodes are decimated
+typedef struct{
+    vector <long> fn;    // list of live factor nodes
+    double e_dead;       // energy of the factor nodes that were removed
+}Tlive;
+
+
+// indexed max-heap with the nodes that have not been decimated, ordered by |pi - 0.5|.
+// Ties are broken by the smallest index of the node.
+typedef struct{
+    vector <long> heap;   // heap[k] is the node at position k in the heap
+    vector <long> pos;    // pos[i] is the position of node i in the heap (-1 if it is not there)
+    vector <double> key;  // key[i] is the bias |pi - 0.5| of node i when the heap was last updated
+    vector <long> dirty;  // nodes whose pi changed since the last update of the heap
+}Theap;
+
+
 void init_graph(Tnode *&nodes, Thedge *&hedges, long N, long M){
     nodes = new Tnode[N];
     hedges = new Thedge[M];
@@ -59,6 +89,7 @@ void init_graph(Tnode *&nodes, Thedge *&hedges, long N, long M){
         nodes[i].fn_in = vector <long> ();
         nodes[i].pos_fn = vector <int> ();
         nodes[i].fixed = false;
+        nodes[i].dirty = false;
         nodes[i].pi = 0.5;
     }
 
@@ -297,6 +328,139 @@ void create_graph(long N, long M, int K, Tnode *&nodes, Thedge *&hedges, gsl_rng
     }
 }
 
+// header of the binary graph files written by Graph_to_binary.cpp, where the format is described
+typedef struct{
+    char magic[4];
+    int32_t version;
+    int32_t K;
+    int32_t unused;
+    int64_t N;
+    int64_t M;
+}Tgraph_header;
+
+
+// FNV-1a hash of n bytes, taken 8 bytes at a time. It identifies the graph file in the checkpoints
+uint64_t hash_bytes(const char *data, long n){
+    uint64_t h = 14695981039346656037ULL;
+    uint64_t word;
+    long i = 0;
+    for (; i + 8 <= n; i += 8){
+        memcpy(&word, data + i, 8);
+        h = (h ^ word) * 1099511628211ULL;
+    }
+    for (; i < n; i++){
+        h = (h ^ (unsigned char) data[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+
+// This function maps a binary graph file in memory and fills the nodes and the factor nodes from its
+// arrays, in the same order as create_graph. The file is only read, so the processes that load the same
+// instance share its pages. It returns false if the file is not a valid graph. graph_size and graph_hash
+// identify the file
+bool read_graph_bin(char *filegraph, long &N, long &M, int &K, Tnode *&nodes, Thedge *&hedges, 
+                    int64_t &graph_size, uint64_t &graph_hash){
+    int fd = open(filegraph, O_RDONLY);
+    if (fd < 0){
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < sizeof(Tgraph_header)){
+        close(fd);
+        return false;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED){
+        return false;
+    }
+
+    Tgraph_header *header = (Tgraph_header *) map;
+    long nocc = header->M * header->K;
+    long size = sizeof(Tgraph_header) + (header->N + 1 + 2 * nocc) * sizeof(int64_t) + 
+                nocc * (sizeof(int32_t) + sizeof(int8_t));
+    if (memcmp(header->magic, "AMEG", 4) != 0 || header->version != 1 || header->K < 1 || 
+        header->N < 0 || header->M < 0 || st.st_size != size){
+        munmap(map, st.st_size);
+        return false;
+    }
+    N = header->N;
+    M = header->M;
+    K = header->K;
+    int64_t *clause_nodes = (int64_t *) (header + 1);
+    int64_t *node_start = clause_nodes + nocc;
+    int64_t *node_fn = node_start + N + 1;
+    int32_t *node_pos = (int32_t *) (node_fn + nocc);
+    int8_t *clause_links = (int8_t *) (node_pos + nocc);
+
+    bool valid = (node_start[0] == 0 && node_start[N] == nocc);
+    for (long i = 0; i < N && valid; i++){
+        valid = (node_start[i + 1] >= node_start[i]);
+    }
+    // the links are 1 or -1, and the nodes of a clause are different
+    for (long he = 0; he < M && valid; he++){
+        for (int w = 0; w < K && valid; w++){
+            valid = (clause_nodes[he * K + w] >= 0 && clause_nodes[he * K + w] < N && 
+                     (clause_links[he * K + w] == 1 || clause_links[he * K + w] == -1));
+            for (int h = 0; h < w && valid; h++){
+                valid = (clause_nodes[he * K + h] != clause_nodes[he * K + w]);
+            }
+        }
+    }
+    // every occurrence of node i points to a place of a clause that holds i, and every place of every 
+    // clause is pointed to once, so all the pos_n are set below
+    vector <bool> assigned(nocc, false);
+    long slot;
+    for (long i = 0; i < N && valid; i++){
+        for (long occ = node_start[i]; occ < node_start[i + 1] && valid; occ++){
+            valid = (node_fn[occ] >= 0 && node_fn[occ] < M && node_pos[occ] >= 0 && node_pos[occ] < K);
+            if (valid){
+                slot = node_fn[occ] * K + node_pos[occ];
+                valid = (clause_nodes[slot] == i && !assigned[slot]);
+                assigned[slot] = true;
+            }
+        }
+    }
+    for (long occ = 0; occ < nocc && valid; occ++){
+        valid = assigned[occ];
+    }
+    if (!valid){
+        munmap(map, st.st_size);
+        return false;
+    }
+
+    init_graph(nodes, hedges, N, M);
+    for (long he = 0; he < M; he++){
+        hedges[he].ch_unsat = 0;
+        hedges[he].nodes_in.assign(clause_nodes + he * K, clause_nodes + (he + 1) * K);
+        hedges[he].links.assign(clause_links + he * K, clause_links + (he + 1) * K);
+        hedges[he].pos_n.resize(K);
+        for (int w = 0; w < K; w++){
+            hedges[he].pos_not_fixed.push_back(w);
+            if (clause_links[he * K + w] == 1){
+                hedges[he].ch_unsat += (1 << w);
+            }
+        }
+    }
+
+    for (long i = 0; i < N; i++){
+        nodes[i].nfacn = node_start[i + 1] - node_start[i];
+        nodes[i].fn_in.assign(node_fn + node_start[i], node_fn + node_start[i + 1]);
+        nodes[i].pos_fn.assign(node_pos + node_start[i], node_pos + node_start[i + 1]);
+        nodes[i].nch = (long) pow(2, nodes[i].nfacn);
+        for (int k = 0; k < nodes[i].nfacn; k++){
+            hedges[nodes[i].fn_in[k]].pos_n[nodes[i].pos_fn[k]] = k;
+        }
+    }
+
+    graph_size = st.st_size;
+    graph_hash = hash_bytes((const char *) map, st.st_size);
+    munmap(map, st.st_size);
+    return true;
+}
+
+
 
 void get_info_exc(Tnode *nodes, Thedge *hedges, long N, long M, int K){
     int w, count;
@@ -413,6 +577,53 @@ void update_prob_joint(double **prob_joint, long M, int K, int nch_fn,
 }
 
 
+// it updates only the joint probabilities of the factor nodes that contain a node that has
+// just been decimated. The joint probabilities are conditioned on the value of the fixed node,
+// so the correlations built by the integration are kept. If the fixed value had almost zero 
+// probability, the joint probability of that factor node is rebuilt from the pi values.
+// It returns the change in the energy
+double update_prob_joint_fixed(double **prob_joint, int K, int nch_fn, Tnode *nodes, 
+                               Thedge *hedges, long node, double eps = 1e-12){
+    long he;
+    int w, bit, bit_fix;
+    double norm, prod;
+    double de = 0;
+    bit_fix = (1 - nodes[node].dec_value) / 2;
+    for (int hind = 0; hind < nodes[node].nfacn; hind++){
+        he = nodes[node].fn_in[hind];
+        w = nodes[node].pos_fn[hind];
+        de -= prob_joint[he][hedges[he].ch_unsat];
+        norm = 0;
+        for (int ch = 0; ch < nch_fn; ch++){
+            if (((ch >> w) & 1) == bit_fix){
+                norm += prob_joint[he][ch];
+            }
+        }
+
+        if (norm > eps){
+            for (int ch = 0; ch < nch_fn; ch++){
+                if (((ch >> w) & 1) == bit_fix){
+                    prob_joint[he][ch] /= norm;
+                }else{
+                    prob_joint[he][ch] = 0;
+                }
+            }
+        }else{
+            for (int ch = 0; ch < nch_fn; ch++){
+                prod = 1;
+                for (int v = 0; v < K; v++){
+                    bit = ((ch >> v) & 1);
+                    prod *= (bit + (1 - 2 * bit) * nodes[hedges[he].nodes_in[v]].pi);
+                }
+                prob_joint[he][ch] = prod;
+            }
+        }
+        de += prob_joint[he][hedges[he].ch_unsat];
+    }
+    return de;
+}
+
+
 // initializes the auxiliary arrays for the Runge-Kutta integration
 void init_RK_arr(double **&k1, double **&k2, double **&prob_joint_1, long M, 
                 int nch_fn){
@@ -459,15 +670,151 @@ double rate_fms(int E0, int E1, double **rates, double e_av){
 }
 
 
+// true if the node i must be above the node j in the heap
+bool heap_above(Theap &hp, long i, long j){
+    return hp.key[i] > hp.key[j] || (hp.key[i] == hp.key[j] && i < j);
+}
+
+
+void heap_swap(Theap &hp, long k1, long k2){
+    long tmp = hp.heap[k1];
+    hp.heap[k1] = hp.heap[k2];
+    hp.heap[k2] = tmp;
+    hp.pos[hp.heap[k1]] = k1;
+    hp.pos[hp.heap[k2]] = k2;
+}
+
+
+void heap_sift_up(Theap &hp, long k){
+    while (k > 0 && heap_above(hp, hp.heap[k], hp.heap[(k - 1) / 2])){
+        heap_swap(hp, k, (k - 1) / 2);
+        k = (k - 1) / 2;
+    }
+}
+
+
+void heap_sift_down(Theap &hp, long k){
+    long size = hp.heap.size();
+    long child;
+    while (2 * k + 1 < size){
+        child = 2 * k + 1;
+        if (child + 1 < size && heap_above(hp, hp.heap[child + 1], hp.heap[child])){
+            child++;
+        }
+        if (!heap_above(hp, hp.heap[child], hp.heap[k])){
+            break;
+        }
+        heap_swap(hp, k, child);
+        k = child;
+    }
+}
+
+
+// builds the heap with all the nodes that have not been decimated
+void init_heap(Theap &hp, Tnode *nodes, long N){
+    hp.heap = vector <long> ();
+    hp.pos = vector <long> (N, -1);
+    hp.key = vector <double> (N);
+    hp.dirty = vector <long> ();
+    for (long i = 0; i < N; i++){
+        nodes[i].dirty = false;
+        hp.key[i] = fabs(nodes[i].pi - 0.5);
+        if (!nodes[i].fixed){
+            hp.pos[i] = hp.heap.size();
+            hp.heap.push_back(i);
+        }
+    }
+    for (long k = (long) hp.heap.size() / 2 - 1; k >= 0; k--){
+        heap_sift_down(hp, k);
+    }
+}
+
+
+// it marks the node as changed, so that its position in the heap is updated before the 
+// next decimation
+void mark_dirty(Theap &hp, Tnode *nodes, long node){
+    if (!nodes[node].dirty){
+        nodes[node].dirty = true;
+        hp.dirty.push_back(node);
+    }
+}
+
+
+// it updates the keys of the nodes whose bias changed since the last call. Moving each of them 
+// costs O(log n) in a heap of n nodes, so when there are more than about n / log2(n) of them the 
+// heap is built again from the bottom in O(n), as in init_heap. Both give the same order of the 
+// nodes, since ties are broken by the index
+void heap_refresh(Theap &hp, Tnode *nodes){
+    long node;
+    double old_key;
+    long size = hp.heap.size();
+    long log_size = 1;
+    while ((1L << log_size) < size){
+        log_size++;
+    }
+    bool rebuild = ((long) hp.dirty.size() * log_size >= size);
+    for (long d = 0; d < hp.dirty.size(); d++){
+        node = hp.dirty[d];
+        nodes[node].dirty = false;
+        if (hp.pos[node] < 0){
+            continue;
+        }
+        old_key = hp.key[node];
+        hp.key[node] = fabs(nodes[node].pi - 0.5);
+        if (rebuild){
+            continue;
+        }
+        if (hp.key[node] > old_key){
+            heap_sift_up(hp, hp.pos[node]);
+        }else if (hp.key[node] < old_key){
+            heap_sift_down(hp, hp.pos[node]);
+        }
+    }
+    if (rebuild){
+        for (long k = size / 2 - 1; k >= 0; k--){
+            heap_sift_down(hp, k);
+        }
+    }
+    hp.dirty.clear();
+}
+
+
+// it removes the top of the heap and returns the corresponding node
+long heap_pop(Theap &hp){
+    long top = hp.heap[0];
+    heap_swap(hp, 0, hp.heap.size() - 1);
+    hp.heap.pop_back();
+    hp.pos[top] = -1;
+    if (hp.heap.size() > 0){
+        heap_sift_down(hp, 0);
+    }
+    return top;
+}
+
+
+// After a decimation the joint probabilities can have a variable whose marginal is exactly zero.
+// The conditional probability is then multiplied by zero in the equations, and any finite
+// value can be used
+double cond_prob(double p_joint, double p_marg){
+    if (p_marg > 0){
+        return p_joint / p_marg;
+    }else{
+        return 0;
+    }
+}
+
+
 // it computes the conditional probabilities of having a partially unsatisfied clause, given the 
 // value of one variable in the clause
-void comp_pcond(double **prob_joint, double ***pu_cond, Thedge *hedges, long M, int nch_fn, 
-                Tnode *nodes){
+void comp_pcond(double **prob_joint, double ***pu_cond, Thedge *hedges, Tlive &live, int nch_fn, 
+                Tnode *nodes, Theap &hp){
     double pu;
     int bit;
     int ch_uns_flip;
     int w;
-    for (long he = 0; he < M; he++){
+    long he;
+    for (long lind = 0; lind < live.fn.size(); lind++){
+        he = live.fn[lind];
         for (int ind = 0; ind < hedges[he].pos_not_fixed.size(); ind++){
             w = hedges[he].pos_not_fixed[ind];
             nodes[hedges[he].nodes_in[w]].pi = 0;
@@ -476,13 +823,16 @@ void comp_pcond(double **prob_joint, double ***pu_cond, Thedge *hedges, long M,
                 bit = ((ch >> w) & 1);
                 nodes[hedges[he].nodes_in[w]].pi += (1 - bit) * prob_joint[he][ch];
             }
+            if (fabs(nodes[hedges[he].nodes_in[w]].pi - 0.5) != hp.key[hedges[he].nodes_in[w]]){
+                mark_dirty(hp, nodes, hedges[he].nodes_in[w]);
+            }
 
             bit = ((hedges[he].ch_unsat >> w) & 1); 
             ch_uns_flip = (hedges[he].ch_unsat ^ (1 << w));
-            pu_cond[he][w][bit] = prob_joint[he][hedges[he].ch_unsat] / 
-                                  (bit + (1 - 2 * bit) * nodes[hedges[he].nodes_in[w]].pi);
-            pu_cond[he][w][1 - bit] = prob_joint[he][ch_uns_flip] / 
-                                  (1 - bit - (1 - 2 * bit) * nodes[hedges[he].nodes_in[w]].pi);
+            pu_cond[he][w][bit] = cond_prob(prob_joint[he][hedges[he].ch_unsat], 
+                                            bit + (1 - 2 * bit) * nodes[hedges[he].nodes_in[w]].pi);
+            pu_cond[he][w][1 - bit] = cond_prob(prob_joint[he][ch_uns_flip], 
+                                                1 - bit - (1 - 2 * bit) * nodes[hedges[he].nodes_in[w]].pi);
         }
     }
 }
@@ -634,17 +984,21 @@ void sum_fms(long node, int fn_src, Tnode *nodes, Thedge *hedges,
 
 
 // it computes all the derivatives of the joint probabilities
+// only the live factor nodes are considered
 void der_fms(Tnode *nodes, Thedge *hedges, double **prob_joint, double ***pu_cond, 
-             double **rates, long M, int K, int nch_fn, double e_av, double **me_sum){
-    for (long he = 0; he < M; he++){
+             double **rates, Tlive &live, int K, int nch_fn, double e_av, double **me_sum){
+    long he;
+    for (long lind = 0; lind < live.fn.size(); lind++){
+        he = live.fn[lind];
         for (int ch = 0; ch < nch_fn; ch++){
             me_sum[he][ch] = 0;
         }
     }
 
     // candidate to be a parallel for
-    #pragma omp parallel for
-    for (long he = 0; he < M; he++){
+    #pragma omp parallel for private(he)
+    for (long lind = 0; lind < live.fn.size(); lind++){
+        he = live.fn[lind];
         for (int ind = 0; ind < hedges[he].pos_not_fixed.size(); ind++){
             sum_fms(hedges[he].nodes_in[hedges[he].pos_not_fixed[ind]], hedges[he].pos_n[hedges[he].pos_not_fixed[ind]], 
                     nodes, hedges, prob_joint[he], pu_cond, rates, nch_fn, e_av, me_sum[he]);
@@ -653,64 +1007,187 @@ void der_fms(Tnode *nodes, Thedge *hedges, double **prob_joint, double ***pu_con
 }
 
 
-double energy(double **prob_joint, Thedge *hedges, long M){
-    double e = 0;
-    for (long he = 0; he < M; he++){
+double energy(double **prob_joint, Thedge *hedges, Tlive &live){
+    double e = live.e_dead;
+    long he;
+    for (long ind = 0; ind < live.fn.size(); ind++){
+        he = live.fn[ind];
         e += prob_joint[he][hedges[he].ch_unsat];
     }
     return e;
 }
 
 
-void decimate(Tnode *nodes, int N, Thedge *hedges){
-    long max_index;
-    double max_value = -1;
-    double pi_max;
-    for (long i = 0; i < N; i++){
-        if (!nodes[i].fixed){
-            if (fabs(nodes[i].pi - 0.5) > max_value){
-                max_value = fabs(nodes[i].pi - 0.5);
-                max_index = i;
-                pi_max = nodes[i].pi;
-            }
-            // nodes[i].pi = 0.5;
-        }
+// it removes an arbitrary node from the heap
+void heap_remove(Theap &hp, long node){
+    long k = hp.pos[node];
+    if (k < 0){
+        return;
     }
-    if (pi_max > 0.5){
-        nodes[max_index].dec_value = 1;
-        nodes[max_index].pi = 1;
-    }else{
-        nodes[max_index].dec_value = -1;
-        nodes[max_index].pi = 0;
+    heap_swap(hp, k, hp.heap.size() - 1);
+    hp.heap.pop_back();
+    hp.pos[node] = -1;
+    if (k < hp.heap.size()){
+        long moved = hp.heap[k];
+        heap_sift_up(hp, k);
+        heap_sift_down(hp, hp.pos[moved]);
     }
+}
+
+
+// it fixes the node to the value dec_value and removes it from the heap and from the lists of
+// nodes that have not been decimated in its factor nodes
+void fix_node(Tnode *nodes, Thedge *hedges, Theap &hp, long node, int dec_value){
+    heap_remove(hp, node);
+    nodes[node].dec_value = dec_value;
+    nodes[node].pi = (1 + dec_value) / 2;
+    nodes[node].fixed = true;
 
-    nodes[max_index].fixed = true;
     long he;
-    for (int fn = 0; fn < nodes[max_index].nfacn; fn++){
-        he = nodes[max_index].fn_in[fn];
+    for (int fn = 0; fn < nodes[node].nfacn; fn++){
+        he = nodes[node].fn_in[fn];
         for (int ind = 0; ind < hedges[he].pos_not_fixed.size(); ind++){
-            if (hedges[he].nodes_in[hedges[he].pos_not_fixed[ind]] == max_index){
+            if (hedges[he].nodes_in[hedges[he].pos_not_fixed[ind]] == node){
                 hedges[he].pos_not_fixed.erase(hedges[he].pos_not_fixed.begin() + ind);
                 break;
             }
         }
     }
+}
+
+
+// it fixes the most biased node that has not been decimated yet. The node is taken
+// from the top of the heap, once the nodes whose bias changed are updated in it
+long decimate(Tnode *nodes, int N, Thedge *hedges, Theap &hp){
+    heap_refresh(hp, nodes);
+    long max_index = heap_pop(hp);
+    if (nodes[max_index].pi > 0.5){
+        fix_node(nodes, hedges, hp, max_index, 1);
+    }else{
+        fix_node(nodes, hedges, hp, max_index, -1);
+    }
+    return max_index;
+}
+
+
+// true if one of the decimated nodes in the factor node satisfies it
+bool fn_satisfied(Tnode *nodes, Thedge *hedges, long he, int K){
+    for (int w = 0; w < K; w++){
+        if (nodes[hedges[he].nodes_in[w]].fixed && 
+            hedges[he].links[w] * nodes[hedges[he].nodes_in[w]].dec_value == 1){
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void init_live(Tlive &live, Thedge *hedges, long M){
+    live.fn = vector <long> (M);
+    live.e_dead = 0;
+    for (long he = 0; he < M; he++){
+        live.fn[he] = he;
+        hedges[he].pos_live = he;
+    }
+}
+
+
+void remove_live(Tlive &live, Thedge *hedges, long he){
+    long last = live.fn.back();
+    live.fn[hedges[he].pos_live] = last;
+    hedges[last].pos_live = hedges[he].pos_live;
+    live.fn.pop_back();
+    hedges[he].pos_live = -1;
+}
+
+
+// it simplifies the formula after a round of decimation. The factor nodes satisfied by the
+// nodes in fixed_round are removed from the live list, and their conditional probabilities 
+// are set to zero, since they can not be unsatisfied anymore. When a live factor node has only 
+// one node left that is not fixed, and the fixed ones do not satisfy it, that node is fixed
+// to the value that satisfies the factor node (unit propagation). The nodes fixed in this way
+// are appended to fixed_round and propagated in turn. Factor nodes with all their nodes fixed 
+// and unsatisfied are also removed, and their energy is kept in live.e_dead
+void propagate(Tnode *nodes, Thedge *hedges, Theap &hp, Tlive &live, double ***pu_cond, int K,
+               vector <long> &fixed_round){
+    long node, he, var;
+    int w;
+    for (long q = 0; q < fixed_round.size(); q++){
+        node = fixed_round[q];
+        for (int hind = 0; hind < nodes[node].nfacn; hind++){
+            he = nodes[node].fn_in[hind];
+            if (hedges[he].pos_live < 0){
+                continue;
+            }
+            if (fn_satisfied(nodes, hedges, he, K)){
+                remove_live(live, hedges, he);
+                for (int v = 0; v < K; v++){
+                    pu_cond[he][v][0] = 0;
+                    pu_cond[he][v][1] = 0;
+                }
+            }else if (hedges[he].pos_not_fixed.size() == 0){
+                remove_live(live, hedges, he);
+                live.e_dead += 1;
+            }else if (hedges[he].pos_not_fixed.size() == 1){
+                w = hedges[he].pos_not_fixed[0];
+                var = hedges[he].nodes_in[w];
+                fix_node(nodes, hedges, hp, var, hedges[he].links[w]);
+                fixed_round.push_back(var);
+            }
+        }
+    }
+}
+
+
+// it fixes all the variables of one round of decimation and returns how many were fixed.
+// If frac_dec = 0, only the most biased variable is fixed. Otherwise, the round fixes the 
+// fraction frac_dec of the variables that are not fixed yet (sched_dec = 0), or the fraction 
+// frac_dec of all the N variables (sched_dec = 1), and always at least one. After that, it also 
+// fixes every remaining variable with |pi - 0.5| >= thr_dec.
+// The fixed variables are saved in fixed_round
+long decimate_round(Tnode *nodes, long N, Thedge *hedges, Theap &hp, double frac_dec, 
+                    int sched_dec, double thr_dec, vector <long> &fixed_round){
+    fixed_round.clear();
+    long n_not_fixed = hp.heap.size();
+    long ndec = 1;
+    if (frac_dec > 0){
+        if (sched_dec == 0){
+            ndec = (long) (frac_dec * n_not_fixed);
+        }else{
+            ndec = (long) (frac_dec * N);
+        }
+        if (ndec < 1){
+            ndec = 1;
+        }else if (ndec > n_not_fixed){
+            ndec = n_not_fixed;
+        }
+    }
+
+    while (fixed_round.size() < ndec){
+        fixed_round.push_back(decimate(nodes, N, hedges, hp));
+    }
 
+    while (hp.heap.size() > 0 && hp.key[hp.heap[0]] >= thr_dec){
+        fixed_round.push_back(decimate(nodes, N, hedges, hp));
+    }
+    return fixed_round.size();
 }
 
 
 void RK2_fms_step(Tnode *nodes, Thedge *hedges, double **prob_joint, double ***pu_cond,
                   double **rates, long N, long M, int K, int nch_fn, double &e, double **me_sum, 
                   double **k1, double **k2, double **prob_joint_1, double &dt1, double &dt_min, 
-                  double tol, double &t, long ndec, int &niter_each){
+                  double tol, double &t, long ndec, int &niter_each, Theap &hp, Tlive &live){
     bool valid = false;
+    long he;
     
     while (!valid){
     
-        der_fms(nodes, hedges, prob_joint, pu_cond, rates, M, K, nch_fn, e / N, me_sum);   // in the rates, I use the energy density
+        der_fms(nodes, hedges, prob_joint, pu_cond, rates, live, K, nch_fn, e / N, me_sum);   // in the rates, I use the energy density
 
         valid = true;
-        for (long he = 0; he < M; he++){
+        for (long ind = 0; ind < live.fn.size(); ind++){
+            he = live.fn[ind];
             for (int ch = 0; ch < nch_fn; ch++){
                 k1[he][ch] = dt1 * me_sum[he][ch];
                 prob_joint_1[he][ch] = prob_joint[he][ch] + k1[he][ch];
@@ -730,7 +1207,8 @@ void RK2_fms_step(Tnode *nodes, Thedge *hedges, double **prob_joint, double ***p
             }
 
             valid = true;
-            for (long he = 0; he < M; he++){
+            for (long ind = 0; ind < live.fn.size(); ind++){
+                he = live.fn[ind];
                 for (int ch = 0; ch < nch_fn; ch++){
                     k1[he][ch] = dt1 * me_sum[he][ch];
                     prob_joint_1[he][ch] = prob_joint[he][ch] + k1[he][ch];
@@ -741,13 +1219,14 @@ void RK2_fms_step(Tnode *nodes, Thedge *hedges, double **prob_joint, double ***p
             }
         }
             
-        e = energy(prob_joint_1, hedges, M);
-        comp_pcond(prob_joint_1, pu_cond, hedges, M, nch_fn, nodes);
+        e = energy(prob_joint_1, hedges, live);
+        comp_pcond(prob_joint_1, pu_cond, hedges, live, nch_fn, nodes, hp);
 
-        der_fms(nodes, hedges, prob_joint_1, pu_cond, rates, M, K, nch_fn, e / N, me_sum);
+        der_fms(nodes, hedges, prob_joint_1, pu_cond, rates, live, K, nch_fn, e / N, me_sum);
                 
         valid = true;
-        for (long he = 0; he < M; he++){
+        for (long ind = 0; ind < live.fn.size(); ind++){
+            he = live.fn[ind];
             for (int ch = 0; ch < nch_fn; ch++){
                 k2[he][ch] = dt1 * me_sum[he][ch];
                 if (prob_joint[he][ch] + (k1[he][ch] + k2[he][ch]) / 2 < 0){
@@ -762,37 +1241,41 @@ void RK2_fms_step(Tnode *nodes, Thedge *hedges, double **prob_joint, double ***p
                 dt_min /= 2;
                 //  cout << "dt_min also halfed" << endl;
             }
-            e = energy(prob_joint, hedges, M);
-            comp_pcond(prob_joint, pu_cond, hedges, M, nch_fn, nodes);
+            e = energy(prob_joint, hedges, live);
+            comp_pcond(prob_joint, pu_cond, hedges, live, nch_fn, nodes, hp);
         }else{
+            // the error and the largest step are taken over the factor nodes that are still live
+            long nlive = live.fn.size() > 0 ? live.fn.size() : 1;
             double error = 0;
-            for (long he = 0; he < M; he++){
+            for (long ind = 0; ind < live.fn.size(); ind++){
+                he = live.fn[ind];
                 for (int ch = 0; ch < nch_fn; ch++){
                     error += fabs(k1[he][ch] - k2[he][ch]);
                 }
             }
 
-            error /= nch_fn * M;
+            error /= nch_fn * nlive;
 
             if (error < 2 * tol){
                 t += dt1;
                 niter_each++;
-                for (long he = 0; he < M; he++){
+                for (long ind = 0; ind < live.fn.size(); ind++){
+                    he = live.fn[ind];
                     for (int ch = 0; ch < nch_fn; ch++){
                         prob_joint[he][ch] += (k1[he][ch] + k2[he][ch]) / 2;
                     }
                 }
-                e = energy(prob_joint, hedges, M);
-                comp_pcond(prob_joint, pu_cond, hedges, M, nch_fn, nodes);
+                e = energy(prob_joint, hedges, live);
+                comp_pcond(prob_joint, pu_cond, hedges, live, nch_fn, nodes, hp);
             }else{
-                e = energy(prob_joint, hedges, M);
-                comp_pcond(prob_joint, pu_cond, hedges, M, nch_fn, nodes);
+                e = energy(prob_joint, hedges, live);
+                comp_pcond(prob_joint, pu_cond, hedges, live, nch_fn, nodes, hp);
                 valid = false;
             }
 
             dt1 = 4 * dt1 * sqrt(2 * tol / error) / 5;
-            if (dt1 > M){
-                    dt1 = M;
+            if (dt1 > nlive){
+                    dt1 = nlive;
             }else if(dt1 < dt_min){
                 dt1 = dt_min;
             }
@@ -802,10 +1285,274 @@ void RK2_fms_step(Tnode *nodes, Thedge *hedges, double **prob_joint, double ***p
 }
 
 
+// Checkpoints of the decimation. When check_s > 0, every check_s seconds of wall time, at the
+// beginning of a round, the whole state of the decimation (the probabilities, the decimated nodes,
+// the heap, the live factor nodes and the counters) is copied to memory. A second thread writes the
+// copy to filecheck.tmp and renames it to filecheck, so the integration does not wait for the disk and
+// filecheck is always a complete checkpoint. A run started with resume=1 builds the graph again, goes
+// on from filecheck, if it exists, and writes the same output as a run that was never stopped. The
+// runtime adds the time before the checkpoint, which is saved with it. The checkpoint is removed when
+// the run ends.
+typedef struct{
+    char magic[4];
+    int32_t version;
+    int32_t K;
+    int32_t nch_fn;
+    int64_t N;
+    int64_t M;
+    double eta;
+    double tol;
+    int32_t steps_dec;
+    int32_t sched_dec;
+    double frac_dec;
+    double thr_dec;
+    int32_t reset_dec;
+    int32_t simplify;
+    int64_t graph_size;     // size of the binary graph file, 0 if the graph was generated
+    uint64_t graph_hash;    // hash of that file (see hash_bytes)
+}Tcheck_header;
+
+
+typedef struct{
+    string file;
+    Tcheck_header header;
+    double every;       // seconds between checkpoints, 0 if there are no checkpoints
+    double last;        // time of the last checkpoint
+    thread writer;      // it writes the last checkpoint
+    string bytes;       // last checkpoint, kept while the writer uses it
+    bool resumed;       // if the run goes on from a checkpoint
+    string saved;       // checkpoint read to resume
+    long pos;           // next byte to read in saved
+}Tcheck;
+
+
+double check_clock(){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+// the checkpoint is fileener with .chk instead of .txt
+void init_check(Tcheck &ck, char *fileener, double every, long N, long M, int K, int nch_fn, double eta,
+                double tol, int steps_dec, double frac_dec, int sched_dec, double thr_dec, bool reset_dec,
+                bool simplify, int64_t graph_size, uint64_t graph_hash){
+    ck.file = fileener;
+    if (ck.file.size() > 4 && ck.file.compare(ck.file.size() - 4, 4, ".txt") == 0){
+        ck.file.resize(ck.file.size() - 4);
+    }
+    ck.file += ".chk";
+    memset(&ck.header, 0, sizeof(Tcheck_header));
+    memcpy(ck.header.magic, "AMED", 4);
+    ck.header.version = 3;
+    ck.header.K = K;
+    ck.header.nch_fn = nch_fn;
+    ck.header.N = N;
+    ck.header.M = M;
+    ck.header.eta = eta;
+    ck.header.tol = tol;
+    ck.header.steps_dec = steps_dec;
+    ck.header.sched_dec = sched_dec;
+    ck.header.frac_dec = frac_dec;
+    ck.header.thr_dec = thr_dec;
+    ck.header.reset_dec = reset_dec;
+    ck.header.simplify = simplify;
+    ck.header.graph_size = graph_size;
+    ck.header.graph_hash = graph_hash;
+    ck.every = every;
+    ck.last = check_clock();
+    ck.resumed = false;
+    ck.pos = 0;
+}
+
+
+// it reads the checkpoint to resume from. If there is no file, the run starts from the beginning. It returns
+// false if the file was written by a run with other parameters
+bool read_check(Tcheck &ck){
+    ifstream fc(ck.file.c_str(), ios::binary);
+    if (!fc.is_open()){
+        return true;
+    }
+    ostringstream all;
+    all << fc.rdbuf();
+    ck.saved = all.str();
+    ck.resumed = true;
+    if (ck.saved.size() < sizeof(Tcheck_header) ||
+        memcmp(ck.saved.data(), &ck.header, sizeof(Tcheck_header)) != 0){
+        return false;
+    }
+    ck.pos = sizeof(Tcheck_header);
+    return true;
+}
+
+
+void put_check(string &bytes, const void *p, long n){
+    bytes.append((const char *) p, n);
+}
+
+
+bool get_check(Tcheck &ck, void *p, long n){
+    if (ck.pos + n > (long) ck.saved.size()){
+        return false;
+    }
+    memcpy(p, ck.saved.data() + ck.pos, n);
+    ck.pos += n;
+    return true;
+}
+
+
+bool check_due(Tcheck &ck){
+    return ck.every > 0 && check_clock() - ck.last >= ck.every;
+}
+
+
+void write_check_file(string file, string *bytes){
+    string filetmp = file + ".tmp";
+    ofstream fc(filetmp.c_str(), ios::binary);
+    fc.write(bytes->data(), bytes->size());
+    fc.close();
+    if (!fc.fail()){
+        rename(filetmp.c_str(), file.c_str());
+    }
+}
+
+
+// it gives the new checkpoint to the writer, once it finished with the previous one
+void start_check(Tcheck &ck, string &bytes){
+    if (ck.writer.joinable()){
+        ck.writer.join();
+    }
+    ck.bytes.swap(bytes);
+    ck.writer = thread(write_check_file, ck.file, &ck.bytes);
+    ck.last = check_clock();
+}
+
+
+void wait_check(Tcheck &ck){
+    if (ck.writer.joinable()){
+        ck.writer.join();
+    }
+    ck.bytes.clear();
+}
+
+
+// it is called when the output of the run is complete
+void end_check(Tcheck &ck){
+    wait_check(ck);
+    if (ck.every > 0 || ck.resumed){
+        remove(ck.file.c_str());
+    }
+}
+
+
+// lists of variable length are saved with their size in front
+template <typename T> void put_vector(string &bytes, vector <T> &v){
+    int64_t n = v.size();
+    put_check(bytes, &n, sizeof(int64_t));
+    put_check(bytes, v.data(), n * sizeof(T));
+}
+
+
+template <typename T> bool get_vector(Tcheck &ck, vector <T> &v){
+    int64_t n;
+    if (!get_check(ck, &n, sizeof(int64_t)) || n < 0 || ck.pos + n * (long) sizeof(T) > (long) ck.saved.size()){
+        return false;
+    }
+    v.resize(n);
+    return get_check(ck, v.data(), n * sizeof(T));
+}
+
+
+// it copies the state of the decimation to a new checkpoint, see Tcheck
+void save_check(Tcheck &ck, Tnode *nodes, Thedge *hedges, long N, long M, int K, int nch_fn, 
+                double **prob_joint, double ***pu_cond, Theap &hp, Tlive &live, double e, double dt1, 
+                double dt_min, long niter_final, long nfixed, long nrounds, double elapsed){
+    string bytes;
+    bytes.reserve(sizeof(Tcheck_header) + M * (nch_fn + 2 * K) * sizeof(double) + 
+                  N * (3 * sizeof(double) + 2 * sizeof(long)) + 4096);
+    put_check(bytes, &ck.header, sizeof(Tcheck_header));
+    double scalars[5] = {e, dt1, dt_min, live.e_dead, elapsed};
+    put_check(bytes, scalars, sizeof(scalars));
+    int64_t counters[3] = {niter_final, nfixed, nrounds};
+    put_check(bytes, counters, sizeof(counters));
+
+    int32_t flags[3];
+    for (long i = 0; i < N; i++){
+        put_check(bytes, &nodes[i].pi, sizeof(double));
+        flags[0] = nodes[i].fixed;
+        flags[1] = nodes[i].dec_value;
+        flags[2] = nodes[i].dirty;
+        put_check(bytes, flags, sizeof(flags));
+    }
+    for (long he = 0; he < M; he++){
+        put_check(bytes, &hedges[he].pos_live, sizeof(long));
+        put_vector(bytes, hedges[he].pos_not_fixed);
+        put_check(bytes, prob_joint[he], nch_fn * sizeof(double));
+        for (int w = 0; w < K; w++){
+            put_check(bytes, pu_cond[he][w], 2 * sizeof(double));
+        }
+    }
+    put_vector(bytes, live.fn);
+    put_vector(bytes, hp.heap);
+    put_vector(bytes, hp.pos);
+    put_vector(bytes, hp.key);
+    put_vector(bytes, hp.dirty);
+    start_check(ck, bytes);
+}
+
+
+bool load_check(Tcheck &ck, Tnode *nodes, Thedge *hedges, long N, long M, int K, int nch_fn, 
+                double **prob_joint, double ***pu_cond, Theap &hp, Tlive &live, double &e, double &dt1, 
+                double &dt_min, long &niter_final, long &nfixed, long &nrounds, double &elapsed){
+    double scalars[5];
+    int64_t counters[3];
+    if (!get_check(ck, scalars, sizeof(scalars)) || !get_check(ck, counters, sizeof(counters))){
+        return false;
+    }
+    e = scalars[0];
+    dt1 = scalars[1];
+    dt_min = scalars[2];
+    live.e_dead = scalars[3];
+    elapsed = scalars[4];
+    niter_final = counters[0];
+    nfixed = counters[1];
+    nrounds = counters[2];
+
+    int32_t flags[3];
+    for (long i = 0; i < N; i++){
+        if (!get_check(ck, &nodes[i].pi, sizeof(double)) || !get_check(ck, flags, sizeof(flags))){
+            return false;
+        }
+        nodes[i].fixed = flags[0];
+        nodes[i].dec_value = flags[1];
+        nodes[i].dirty = flags[2];
+    }
+    for (long he = 0; he < M; he++){
+        if (!get_check(ck, &hedges[he].pos_live, sizeof(long)) || !get_vector(ck, hedges[he].pos_not_fixed) ||
+            !get_check(ck, prob_joint[he], nch_fn * sizeof(double))){
+            return false;
+        }
+        for (int w = 0; w < K; w++){
+            if (!get_check(ck, pu_cond[he][w], 2 * sizeof(double))){
+                return false;
+            }
+        }
+    }
+    if (!get_vector(ck, live.fn) || !get_vector(ck, hp.heap) || !get_vector(ck, hp.pos) || 
+        !get_vector(ck, hp.key) || !get_vector(ck, hp.dirty)){
+        return false;
+    }
+    bool complete = (ck.pos == ck.saved.size());
+    string().swap(ck.saved);
+    return complete;
+}
+
+
 // peforms the integration of the differential equations with the 2nd order Runge-Kutta
 // the method is implemented with adaptive step size
-void decimation_quadratic_fms(Tnode *nodes, Thedge *hedges, long N, long M, int K, int nch_fn, 
-            double eta, int max_c, char *fileener, int steps_dec, double tol = 1e-2, 
+// It returns false if the checkpoint to resume from cannot be read
+bool decimation_quadratic_fms(Tnode *nodes, Thedge *hedges, long N, long M, int K, int nch_fn, 
+            double eta, int max_c, char *fileener, int steps_dec, double frac_dec, int sched_dec, 
+            double thr_dec, bool reset_dec, bool simplify, Tcheck &ck, 
+            std::chrono::high_resolution_clock::time_point t_start, double &t_before, double tol = 1e-2, 
             double dt0 = 0.01, double dt_min = 1e-7){
     double **rates;
     double **prob_joint, ***pu_cond, **me_sum, **pi;
@@ -814,41 +1561,74 @@ void decimation_quadratic_fms(Tnode *nodes, Thedge *hedges, long N, long M, int
     
     table_all_rates(max_c, K, eta, rates);
     
+    Theap hp;
+    init_heap(hp, nodes, N);
+
+    Tlive live;
+    init_live(live, hedges, M);
+
     init_probs(prob_joint, pu_cond, me_sum, M, K, nch_fn);
     update_prob_joint(prob_joint, M, K, nch_fn, nodes, hedges);
-    comp_pcond(prob_joint, pu_cond, hedges, M, nch_fn, nodes);
+    comp_pcond(prob_joint, pu_cond, hedges, live, nch_fn, nodes, hp);
 
     // initialize auxiliary arrays for the Runge-Kutta integration
     double **k1, **k2, **prob_joint_1;
     init_RK_arr(k1, k2, prob_joint_1, M, nch_fn);
     
-    e = energy(prob_joint, hedges, M);
+    e = energy(prob_joint, hedges, live);
     
     double dt1 = dt0;
     double t;
     int niter_each;
     long niter_final = 0;
+    long nfixed = 0;
+    long nrounds = 0;
+    vector <long> fixed_round;
+
+    // t_before is the runtime before the checkpoint, and the checkpoints save it plus the time since t_start
+    t_before = 0;
+    if (ck.resumed && !load_check(ck, nodes, hedges, N, M, K, nch_fn, prob_joint, pu_cond, hp, live, e, dt1, 
+                                  dt_min, niter_final, nfixed, nrounds, t_before)){
+        return false;
+    }
 
     // the time scale is already given in Monte Carlo steps. Inside the rates I am using 
     // the energy density e_av
 
-    for (long ndec = 0; ndec < N; ndec++){
+    while (nfixed < N){
+        if (check_due(ck)){
+            save_check(ck, nodes, hedges, N, M, K, nch_fn, prob_joint, pu_cond, hp, live, e, dt1, dt_min, 
+                       niter_final, nfixed, nrounds, t_before + std::chrono::duration<double>(
+                       std::chrono::high_resolution_clock::now() - t_start).count());
+        }
         t = 0;
         niter_each = 0;
         while (niter_each < steps_dec && e > 1){
             RK2_fms_step(nodes, hedges, prob_joint, pu_cond, rates, N, M, K, nch_fn, e, me_sum, 
-                         k1, k2, prob_joint_1, dt1, dt_min, tol, t, ndec, niter_each);
+                         k1, k2, prob_joint_1, dt1, dt_min, tol, t, nfixed, niter_each, hp, live);
+        }
+        decimate_round(nodes, N, hedges, hp, frac_dec, sched_dec, thr_dec, fixed_round);
+        if (simplify){
+            propagate(nodes, hedges, hp, live, pu_cond, K, fixed_round);
+        }
+        nfixed = N - hp.heap.size();
+        nrounds++;
+        if (reset_dec){
+            update_prob_joint(prob_joint, M, K, nch_fn, nodes, hedges);
+        }else{
+            for (long ind = 0; ind < fixed_round.size(); ind++){
+                e += update_prob_joint_fixed(prob_joint, K, nch_fn, nodes, hedges, fixed_round[ind]);
+            }
         }
-        decimate(nodes, N, hedges);
-        update_prob_joint(prob_joint, M, K, nch_fn, nodes, hedges);
         niter_final += niter_each;
     }
+    wait_check(ck);
 
     ofstream fe(fileener);
-    fe << "# niters" << "\t" << "ef" << endl;
-    fe << niter_final << "\t" << e << endl;   // it prints the energy density
+    fe << "# niters" << "\t" << "ef" << "\t" << "nrounds" << endl;
+    fe << niter_final << "\t" << e << "\t" << nrounds << endl;   // it prints the energy density
     fe.close();
-
+    return true;
 }
 
 long final_energy(Tnode *nodes, Thedge *hedges, long M, int K){
@@ -886,6 +1666,38 @@ int main(int argc, char *argv[]) {
     int steps_dec = atoi(argv[6]);
     double tol = atof(argv[7]);
     int nthr = atoi(argv[8]);
+    double frac_dec = 0;    // by default, one variable is fixed in each round
+    int sched_dec = 0;
+    double thr_dec = 1;     // the bias |pi - 0.5| is never larger than 0.5
+    if (argc > 9){
+        frac_dec = atof(argv[9]);
+    }
+    if (argc > 10){
+        sched_dec = atoi(argv[10]);
+    }
+    if (argc > 11){
+        thr_dec = atof(argv[11]);
+    }
+    bool reset_dec = false;     // if true, all the joint probabilities are rebuilt after each round
+    if (argc > 12){
+        reset_dec = (atoi(argv[12]) != 0);
+    }
+    bool simplify = true;       // if true, satisfied clauses are removed and unit clauses propagated
+    if (argc > 13){
+        simplify = (atoi(argv[13]) != 0);
+    }
+    char *filegraph_bin = NULL;   // binary graph file, see Graph_to_binary.cpp
+    if (argc > 14 && string(argv[14]) != "-"){
+        filegraph_bin = argv[14];
+    }
+    double check_s = 0;     // wall seconds between checkpoints, 0 writes none (see Tcheck)
+    if (argc > 15){
+        check_s = atof(argv[15]);
+    }
+    bool resume = false;
+    if (argc > 16){
+        resume = (atoi(argv[16]) != 0);
+    }
 
     int nch_fn = (1 << K);
 
@@ -904,15 +1716,39 @@ int main(int argc, char *argv[]) {
     // sprintf(filelinks, "KSAT_K_%d_enlaces_N_%li_M_%li_idumenlaces_-2_idumgraph_-2_ordered.txt", 
     //                    K, N, M);
 
-    char fileener[300]; 
-    sprintf(fileener, "CDA_decimation_FMS_dyn_K_%d_N_%li_M_%li_eta_%.4lf_stepsdec_%d_seed_%li_tol_%.1e.txt", 
-            K, N, M, eta, steps_dec, seed_r, tol);
-
-    char filefinal[300]; 
-    sprintf(filefinal, "CDA_decimation_FMS_final_K_%d_N_%li_M_%li_eta_%.4lf_stepsdec_%d_seed_%li_tol_%.1e.txt", 
-            K, N, M, eta, steps_dec, seed_r, tol);
+    char str_batch[100] = "";
+    if (frac_dec > 0 || thr_dec <= 0.5){
+        sprintf(str_batch, "_fdec_%.4lf_sched_%d_thrdec_%.4lf", frac_dec, sched_dec, thr_dec);
+    }
+    if (reset_dec){
+        strcat(str_batch, "_reset");
+    }
+    if (!simplify){
+        strcat(str_batch, "_nosimp");
+    }
 
-    create_graph(N, M, K, nodes, hedges, r);
+    char fileener[400]; 
+    int64_t graph_size = 0;     // the checkpoints only resume on the same graph
+    uint64_t graph_hash = 0;
+    sprintf(fileener, "CDA_decimation_FMS_dyn_K_%d_N_%li_M_%li_eta_%.4lf_stepsdec_%d%s_seed_%li_tol_%.1e.txt", 
+            K, N, M, eta, steps_dec, str_batch, seed_r, tol);
+
+    char filefinal[400]; 
+    sprintf(filefinal, "CDA_decimation_FMS_final_K_%d_N_%li_M_%li_eta_%.4lf_stepsdec_%d%s_seed_%li_tol_%.1e.txt", 
+            K, N, M, eta, steps_dec, str_batch, seed_r, tol);
+
+    if (filegraph_bin != NULL){
+        long N_file, M_file;
+        int K_file;
+        if (!read_graph_bin(filegraph_bin, N_file, M_file, K_file, nodes, hedges, graph_size, graph_hash) || N_file != N || 
+            M_file != M || K_file != K){
+            cout << "Cannot read the graph " << filegraph_bin << " with N=" << N << " M=" << M << " K=" << K 
+                 << endl;
+            return 1;
+        }
+    }else{
+        create_graph(N, M, K, nodes, hedges, r);
+    }
     // read_graph_old_order(filegraph, N, M, K, nodes, hedges);
     // read_links(filelinks, N, M, K, nodes, hedges);
     auto t1 = std::chrono::high_resolution_clock::now();
@@ -920,16 +1756,31 @@ int main(int argc, char *argv[]) {
     int max_c = get_max_c(nodes, N);
     get_info_exc(nodes, hedges, N, M, K);
 
+    Tcheck check;
+    init_check(check, fileener, check_s, N, M, K, nch_fn, eta, tol, steps_dec, frac_dec, sched_dec, thr_dec, 
+               reset_dec, simplify, graph_size, graph_hash);
+    if (resume && !read_check(check)){
+        cout << "The checkpoint " << check.file << " is not from a run with these parameters and graph" << endl;
+        return 1;
+    }
     
-    decimation_quadratic_fms(nodes, hedges, N, M, K, nch_fn, eta, max_c, fileener, steps_dec, tol);
+    double t_before;
+    if (!decimation_quadratic_fms(nodes, hedges, N, M, K, nch_fn, eta, max_c, fileener, steps_dec, 
+                                  frac_dec, sched_dec, thr_dec, reset_dec, 
+                                  simplify, check, t1, t_before, tol)){
+        cout << "Cannot resume from the checkpoint " << check.file << endl;
+        return 1;
+    }
 
     long ef = final_energy(nodes, hedges, M, K);
 
     auto t2 = std::chrono::high_resolution_clock::now();
 
-    auto ms_int = std::chrono::duration_cast<std::chrono::seconds>(t2 - t1);
+    // a resumed run also counts the time before its checkpoint
+    size_t elapsed_count = (size_t) (t_before + std::chrono::duration<double>(t2 - t1).count());
 
-    print_final(nodes, N, filefinal, ef, ms_int.count());
+    print_final(nodes, N, filefinal, ef, elapsed_count);
+    end_check(check);
 
     return 0;
 }
\ No newline at end of file
@@ -7,6 +7,20 @@
 #include <cmath>
 #include <omp.h>
 #include <chrono>
+#include <cstring>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <sstream>
+#include <string>
+#include <cstdio>
+#include <thread>
+#ifdef _ZLIB
+#include <zlib.h>
+#endif
 
 using namespace std;
     
@@ -306,6 +320,138 @@ void create_graph(long N, long M, int K, Tnode *&nodes, Thedge *&hedges, gsl_rng
     }
 }
 
+// header of the binary graph files written by Graph_to_binary.cpp, where the format is described
+typedef struct{
+    char magic[4];
+    int32_t version;
+    int32_t K;
+    int32_t unused;
+    int64_t N;
+    int64_t M;
+}Tgraph_header;
+
+
+// FNV-1a hash of n bytes, taken 8 bytes at a time. It identifies the graph file in the checkpoints
+uint64_t hash_bytes(const char *data, long n){
+    uint64_t h = 14695981039346656037ULL;
+    uint64_t word;
+    long i = 0;
+    for (; i + 8 <= n; i += 8){
+        memcpy(&word, data + i, 8);
+        h = (h ^ word) * 1099511628211ULL;
+    }
+    for (; i < n; i++){
+        h = (h ^ (unsigned char) data[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+
+// This function maps a binary graph file in memory and fills the nodes and the factor nodes from its
+// arrays, in the same order as create_graph. The file is only read, so the processes that load the same
+// instance share its pages. It returns false if the file is not a valid graph. graph_size and graph_hash
+// identify the file
+bool read_graph_bin(char *filegraph, long &N, long &M, int &K, Tnode *&nodes, Thedge *&hedges, 
+                    int64_t &graph_size, uint64_t &graph_hash){
+    int fd = open(filegraph, O_RDONLY);
+    if (fd < 0){
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < sizeof(Tgraph_header)){
+        close(fd);
+        return false;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED){
+        return false;
+    }
+
+    Tgraph_header *header = (Tgraph_header *) map;
+    long nocc = header->M * header->K;
+    long size = sizeof(Tgraph_header) + (header->N + 1 + 2 * nocc) * sizeof(int64_t) + 
+                nocc * (sizeof(int32_t) + sizeof(int8_t));
+    if (memcmp(header->magic, "AMEG", 4) != 0 || header->version != 1 || header->K < 1 || 
+        header->N < 0 || header->M < 0 || st.st_size != size){
+        munmap(map, st.st_size);
+        return false;
+    }
+    N = header->N;
+    M = header->M;
+    K = header->K;
+    int64_t *clause_nodes = (int64_t *) (header + 1);
+    int64_t *node_start = clause_nodes + nocc;
+    int64_t *node_fn = node_start + N + 1;
+    int32_t *node_pos = (int32_t *) (node_fn + nocc);
+    int8_t *clause_links = (int8_t *) (node_pos + nocc);
+
+    bool valid = (node_start[0] == 0 && node_start[N] == nocc);
+    for (long i = 0; i < N && valid; i++){
+        valid = (node_start[i + 1] >= node_start[i]);
+    }
+    // the links are 1 or -1, and the nodes of a clause are different
+    for (long he = 0; he < M && valid; he++){
+        for (int w = 0; w < K && valid; w++){
+            valid = (clause_nodes[he * K + w] >= 0 && clause_nodes[he * K + w] < N && 
+                     (clause_links[he * K + w] == 1 || clause_links[he * K + w] == -1));
+            for (int h = 0; h < w && valid; h++){
+                valid = (clause_nodes[he * K + h] != clause_nodes[he * K + w]);
+            }
+        }
+    }
+    // every occurrence of node i points to a place of a clause that holds i, and every place of every 
+    // clause is pointed to once, so all the pos_n are set below
+    vector <bool> assigned(nocc, false);
+    long slot;
+    for (long i = 0; i < N && valid; i++){
+        for (long occ = node_start[i]; occ < node_start[i + 1] && valid; occ++){
+            valid = (node_fn[occ] >= 0 && node_fn[occ] < M && node_pos[occ] >= 0 && node_pos[occ] < K);
+            if (valid){
+                slot = node_fn[occ] * K + node_pos[occ];
+                valid = (clause_nodes[slot] == i && !assigned[slot]);
+                assigned[slot] = true;
+            }
+        }
+    }
+    for (long occ = 0; occ < nocc && valid; occ++){
+        valid = assigned[occ];
+    }
+    if (!valid){
+        munmap(map, st.st_size);
+        return false;
+    }
+
+    init_graph(nodes, hedges, N, M);
+    for (long he = 0; he < M; he++){
+        hedges[he].ch_unsat = 0;
+        hedges[he].nodes_in.assign(clause_nodes + he * K, clause_nodes + (he + 1) * K);
+        hedges[he].links.assign(clause_links + he * K, clause_links + (he + 1) * K);
+        hedges[he].pos_n.resize(K);
+        for (int w = 0; w < K; w++){
+            if (clause_links[he * K + w] == 1){
+                hedges[he].ch_unsat += (1 << w);
+            }
+        }
+    }
+
+    for (long i = 0; i < N; i++){
+        nodes[i].nfacn = node_start[i + 1] - node_start[i];
+        nodes[i].fn_in.assign(node_fn + node_start[i], node_fn + node_start[i + 1]);
+        nodes[i].pos_fn.assign(node_pos + node_start[i], node_pos + node_start[i + 1]);
+        nodes[i].nch = (long) pow(2, nodes[i].nfacn);
+        for (int k = 0; k < nodes[i].nfacn; k++){
+            hedges[nodes[i].fn_in[k]].pos_n[nodes[i].pos_fn[k]] = k;
+        }
+    }
+
+    graph_size = st.st_size;
+    graph_hash = hash_bytes((const char *) map, st.st_size);
+    munmap(map, st.st_size);
+    return true;
+}
+
+
 
 void get_info_exc(Tnode *nodes, Thedge *hedges, long N, long M, int K, int nch_fn){
     int w, count, ch_exc;
@@ -889,10 +1035,539 @@ double norm(double *probs, int nelems){
 }
 
 
+// Output of the energy. With format 0 it is the text file of always, with one line 't e' per point.
+// With format 1 it is a binary file (fileener with .bin instead of .txt) with the columns t, e and dt
+// (the step that led to each point), and with format 2 the same binary run is appended, compressed
+// if the program was compiled with zlib, to the container file filecont, which can hold all the runs of
+// a sweep. Binary run: "AMEE", int32 version (1), int32 ncols (3), int32 0, int64 npoints,
+// int64 ninfo, double t[npoints], double e[npoints], double dt[npoints] and the ninfo characters of the
+// lines that the text format has at the end (e.g. the profile). Record of the container: "AMER", int32
+// version (1), int32 compressed, int32 nname, int64 raw_size, int64 stored_size, the name of the run
+// (fileener) and the run itself. Other_programs/read_energy_runs.py reads both.
+// With nlog > 0 only the first point after each time of a grid with nlog points per decade is kept,
+// together with the first and the last point.
+typedef struct{
+    char magic[4];
+    int32_t version;
+    int32_t ncols;
+    int32_t unused;
+    int64_t npoints;
+    int64_t ninfo;
+}Tener_header;
+
+
+typedef struct{
+    char magic[4];
+    int32_t version;
+    int32_t compressed;
+    int32_t nname;
+    int64_t raw_size;
+    int64_t stored_size;
+}Tener_record;
+
+
+typedef struct{
+    int format;
+    int nlog;
+    string name;
+    string filecont;
+    ofstream ftext;
+    vector <double> t, e, dt;
+    string info;
+    long npoints;
+    double next_t;
+    bool pending;   // the last point was skipped by the grid, and is written if it turns out to be the last
+    double t_last, e_last, dt_last;
+}Tener_out;
+
+
+bool open_ener(Tener_out &out, char *fileener, int format, int nlog, char *filecont, bool resume){
+    out.format = format;
+    out.nlog = nlog;
+    out.name = fileener;
+    out.filecont = (filecont != NULL) ? filecont : "";
+    out.npoints = 0;
+    out.next_t = 0;
+    out.pending = false;
+    out.t_last = 0;
+    out.e_last = 0;
+    out.dt_last = 0;
+    if (format == 0){
+        if (resume){
+            return true;    // the file is opened when the checkpoint is read
+        }
+        out.ftext.open(fileener);
+        return out.ftext.is_open();
+    }else if (format == 2){
+        return !out.filecont.empty();
+    }
+    return (format == 1);
+}
+
+
+void write_ener_point(Tener_out &out, double t, double e, double dt){
+    if (out.format == 0){
+        // no endl, so that the stream is not flushed after every step
+        out.ftext << t << "\t" << e << "\n";
+    }else{
+        out.t.push_back(t);
+        out.e.push_back(e);
+        out.dt.push_back(dt);
+    }
+    out.npoints++;
+}
+
+
+void add_ener(Tener_out &out, double t, double e, double dt){
+    if (out.nlog > 0 && out.npoints > 0 && t < out.next_t){
+        out.pending = true;
+        out.t_last = t;
+        out.e_last = e;
+        out.dt_last = dt;
+        return;
+    }
+    write_ener_point(out, t, e, dt);
+    out.pending = false;
+    if (out.nlog > 0 && t > 0){
+        out.next_t = pow(10, (floor(out.nlog * log10(t) + 1e-9) + 1) / out.nlog);
+    }
+}
+
+
+// it builds the binary run
+void ener_bytes(Tener_out &out, string &bytes){
+    Tener_header header;
+    memcpy(header.magic, "AMEE", 4);
+    header.version = 1;
+    header.ncols = 3;
+    header.unused = 0;
+    header.npoints = out.t.size();
+    header.ninfo = out.info.size();
+    bytes.assign((char *) &header, sizeof(Tener_header));
+    bytes.append((char *) out.t.data(), out.t.size() * sizeof(double));
+    bytes.append((char *) out.e.data(), out.e.size() * sizeof(double));
+    bytes.append((char *) out.dt.data(), out.dt.size() * sizeof(double));
+    bytes.append(out.info);
+}
+
+
+// it appends one record to the container. The file is locked, so that the processes of a sweep can
+// write to the same container at the same time
+bool append_record(Tener_out &out, string &bytes){
+    Tener_record record;
+    memcpy(record.magic, "AMER", 4);
+    record.version = 1;
+    record.compressed = 0;
+    record.nname = out.name.size();
+    record.raw_size = bytes.size();
+    string stored = bytes;
+#ifdef _ZLIB
+    uLongf size = compressBound(bytes.size());
+    stored.resize(size);
+    if (compress2((Bytef *) &stored[0], &size, (const Bytef *) bytes.data(), bytes.size(), 6) == Z_OK){
+        stored.resize(size);
+        record.compressed = 1;
+    }else{
+        stored = bytes;
+    }
+#endif
+    record.stored_size = stored.size();
+
+    string all((char *) &record, sizeof(Tener_record));
+    all.append(out.name);
+    all.append(stored);
+
+    int fd = open(out.filecont.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0){
+        return false;
+    }
+    flock(fd, LOCK_EX);
+    long done = 0, w;
+    while (done < all.size()){
+        w = write(fd, all.data() + done, all.size() - done);
+        if (w <= 0){
+            break;
+        }
+        done += w;
+    }
+    flock(fd, LOCK_UN);
+    close(fd);
+    return done == all.size();
+}
+
+
+bool close_ener(Tener_out &out){
+    if (out.pending){
+        write_ener_point(out, out.t_last, out.e_last, out.dt_last);
+        out.pending = false;
+    }
+    if (out.format == 0){
+        out.ftext << out.info;
+        out.ftext.close();
+        return !out.ftext.fail();
+    }
+    string bytes;
+    ener_bytes(out, bytes);
+    if (out.format == 1){
+        string filebin = out.name;
+        if (filebin.size() > 4 && filebin.compare(filebin.size() - 4, 4, ".txt") == 0){
+            filebin.resize(filebin.size() - 4);
+        }
+        filebin += ".bin";
+        ofstream fbin(filebin.c_str(), ios::binary);
+        fbin.write(bytes.data(), bytes.size());
+        fbin.close();
+        return !fbin.fail();
+    }
+    return append_record(out, bytes);
+}
+
+
+// counters of the integration, written at the end of the energy file when prof.on is true.
+// The times are in seconds. dt_hist[b] is the number of accepted steps with
+// 2^(b + DT_HIST_MIN) <= dt < 2^(b + DT_HIST_MIN + 1)
+#define DT_HIST_MIN -40
+#define DT_HIST_MAX 30
+typedef struct{
+    bool on;
+    double t_total, t_cond, t_der, t_stage1, t_stage2, t_energy;
+    long nder, naccept, nreject, nhalf;
+    long dt_hist[DT_HIST_MAX - DT_HIST_MIN];
+}Tprof;
+
+
+void init_prof(Tprof &prof, bool on){
+    prof = Tprof();
+    prof.on = on;
+}
+
+
+// it returns the current time only when the profiling is on, so that it costs nothing otherwise
+double prof_time(Tprof &prof){
+    if (prof.on){
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }else{
+        return 0;
+    }
+}
+
+
+// it adds the time elapsed since t0 to the counter acc
+void prof_add(Tprof &prof, double &acc, double t0){
+    if (prof.on){
+        acc += prof_time(prof) - t0;
+    }
+}
+
+
+void prof_dt(Tprof &prof, double dt){
+    if (prof.on){
+        int b = (int) floor(log2(dt)) - DT_HIST_MIN;
+        b = max(0, min(b, DT_HIST_MAX - DT_HIST_MIN - 1));
+        prof.dt_hist[b]++;
+    }
+}
+
+
+// it writes the counters in lines starting with '#', which go at the end of the energy file so that
+// the programs that read the energy skip them
+void print_prof(ostream &fe, Tprof &prof){
+    fe << "# profile wall_s=" << prof.t_total << " cond_s=" << prof.t_cond << " der_s=" << prof.t_der
+       << " stage1_s=" << prof.t_stage1 << " stage2_s=" << prof.t_stage2 << " energy_s=" << prof.t_energy
+       << " nder=" << prof.nder << " accepted=" << prof.naccept << " rejected=" << prof.nreject
+       << " halvings=" << prof.nhalf << endl;
+    fe << "# dt_hist log2(dt):count";
+    for (int b = 0; b < DT_HIST_MAX - DT_HIST_MIN; b++){
+        if (prof.dt_hist[b] > 0){
+            fe << " " << b + DT_HIST_MIN << ":" << prof.dt_hist[b];
+        }
+    }
+    fe << endl;
+}
+
+
+// Checkpoints of the integration. When check_s > 0, every check_s seconds of wall time, at the
+// beginning of a step, the state of the integrator (t, dt1, dt_min, the energy and the probabilities),
+// the state of the output of the energy and the counters of the profile are copied to memory. A second
+// thread writes the copy to filecheck.tmp and renames it to filecheck, so the integration does not wait
+// for the disk and filecheck is always a complete checkpoint. A run started with resume=1 goes on from
+// filecheck, if it exists, and writes the same output as a run that was never stopped.
+// The checkpoint is removed when the run ends.
+typedef struct{
+    char magic[4];
+    int32_t version;
+    int32_t K;
+    int32_t nch_fn;
+    int64_t N;
+    int64_t M;
+    double par;     // the parameter of the algorithm
+    double tol;
+    int64_t graph_size;     // size of the binary graph file, 0 if the graph was generated
+    uint64_t graph_hash;    // hash of that file (see hash_bytes)
+}Tcheck_header;
+
+
+typedef struct{
+    int32_t format;
+    int32_t nlog;
+    int64_t npoints;
+    int64_t pending;
+    int64_t ntext;      // length of the text file of the energy
+    int64_t nvec;       // points kept in memory by the binary formats
+    double next_t, t_last, e_last, dt_last;
+}Tener_state;
+
+
+typedef struct{
+    string file;
+    Tcheck_header header;
+    double every;       // seconds between checkpoints, 0 if there are no checkpoints
+    double last;        // time of the last checkpoint
+    thread writer;      // it writes the last checkpoint
+    string bytes;       // last checkpoint, kept while the writer uses it
+    bool resumed;       // if the run goes on from a checkpoint
+    string saved;       // checkpoint read to resume
+    long pos;           // next byte to read in saved
+}Tcheck;
+
+
+double check_clock(){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+// the checkpoint is fileener with .chk instead of .txt
+void init_check(Tcheck &ck, char *fileener, double every, long N, long M, int K, int nch_fn,
+                double par, double tol, int64_t graph_size, uint64_t graph_hash){
+    ck.file = fileener;
+    if (ck.file.size() > 4 && ck.file.compare(ck.file.size() - 4, 4, ".txt") == 0){
+        ck.file.resize(ck.file.size() - 4);
+    }
+    ck.file += ".chk";
+    memset(&ck.header, 0, sizeof(Tcheck_header));
+    memcpy(ck.header.magic, "AMEK", 4);
+    ck.header.version = 2;
+    ck.header.K = K;
+    ck.header.nch_fn = nch_fn;
+    ck.header.N = N;
+    ck.header.M = M;
+    ck.header.par = par;
+    ck.header.tol = tol;
+    ck.header.graph_size = graph_size;
+    ck.header.graph_hash = graph_hash;
+    ck.every = every;
+    ck.last = check_clock();
+    ck.resumed = false;
+    ck.pos = 0;
+}
+
+
+// it reads the checkpoint to resume from. If there is no file, the run starts from t0. It returns
+// false if the file was written by a run with other parameters
+bool read_check(Tcheck &ck){
+    ifstream fc(ck.file.c_str(), ios::binary);
+    if (!fc.is_open()){
+        return true;
+    }
+    ostringstream all;
+    all << fc.rdbuf();
+    ck.saved = all.str();
+    ck.resumed = true;
+    if (ck.saved.size() < sizeof(Tcheck_header) ||
+        memcmp(ck.saved.data(), &ck.header, sizeof(Tcheck_header)) != 0){
+        return false;
+    }
+    ck.pos = sizeof(Tcheck_header);
+    return true;
+}
+
+
+void put_check(string &bytes, const void *p, long n){
+    bytes.append((const char *) p, n);
+}
+
+
+bool get_check(Tcheck &ck, void *p, long n){
+    if (ck.pos + n > (long) ck.saved.size()){
+        return false;
+    }
+    memcpy(p, ck.saved.data() + ck.pos, n);
+    ck.pos += n;
+    return true;
+}
+
+
+bool check_due(Tcheck &ck){
+    return ck.every > 0 && check_clock() - ck.last >= ck.every;
+}
+
+
+void write_check_file(string file, string *bytes){
+    string filetmp = file + ".tmp";
+    ofstream fc(filetmp.c_str(), ios::binary);
+    fc.write(bytes->data(), bytes->size());
+    fc.close();
+    if (!fc.fail()){
+        rename(filetmp.c_str(), file.c_str());
+    }
+}
+
+
+// it gives the new checkpoint to the writer, once it finished with the previous one
+void start_check(Tcheck &ck, string &bytes){
+    if (ck.writer.joinable()){
+        ck.writer.join();
+    }
+    ck.bytes.swap(bytes);
+    ck.writer = thread(write_check_file, ck.file, &ck.bytes);
+    ck.last = check_clock();
+}
+
+
+void wait_check(Tcheck &ck){
+    if (ck.writer.joinable()){
+        ck.writer.join();
+    }
+    ck.bytes.clear();
+}
+
+
+// it is called when the output of the run is complete
+void end_check(Tcheck &ck){
+    wait_check(ck);
+    if (ck.every > 0 || ck.resumed){
+        remove(ck.file.c_str());
+    }
+}
+
+
+// the text file of the energy is flushed, and resuming cuts it at its length at the checkpoint
+void put_ener_state(string &bytes, Tener_out &out){
+    Tener_state st;
+    memset(&st, 0, sizeof(Tener_state));
+    st.format = out.format;
+    st.nlog = out.nlog;
+    st.npoints = out.npoints;
+    st.pending = out.pending;
+    if (out.format == 0){
+        out.ftext.flush();
+        st.ntext = out.ftext.tellp();
+    }
+    st.nvec = out.t.size();
+    st.next_t = out.next_t;
+    st.t_last = out.t_last;
+    st.e_last = out.e_last;
+    st.dt_last = out.dt_last;
+    put_check(bytes, &st, sizeof(Tener_state));
+    put_check(bytes, out.t.data(), st.nvec * sizeof(double));
+    put_check(bytes, out.e.data(), st.nvec * sizeof(double));
+    put_check(bytes, out.dt.data(), st.nvec * sizeof(double));
+}
+
+
+bool get_ener_state(Tcheck &ck, Tener_out &out){
+    Tener_state st;
+    if (!get_check(ck, &st, sizeof(Tener_state)) || st.format != out.format || st.nlog != out.nlog){
+        return false;
+    }
+    out.npoints = st.npoints;
+    out.pending = st.pending;
+    out.next_t = st.next_t;
+    out.t_last = st.t_last;
+    out.e_last = st.e_last;
+    out.dt_last = st.dt_last;
+    out.t.resize(st.nvec);
+    out.e.resize(st.nvec);
+    out.dt.resize(st.nvec);
+    if (!get_check(ck, out.t.data(), st.nvec * sizeof(double)) ||
+        !get_check(ck, out.e.data(), st.nvec * sizeof(double)) ||
+        !get_check(ck, out.dt.data(), st.nvec * sizeof(double))){
+        return false;
+    }
+    if (out.format == 0){
+        if (truncate(out.name.c_str(), st.ntext) != 0){
+            return false;
+        }
+        out.ftext.open(out.name.c_str(), ios::app);
+        return out.ftext.is_open();
+    }
+    return true;
+}
+
+
+// the counters of the profile go on from the checkpoint. t_total has the time until the checkpoint
+void put_prof_state(string &bytes, Tprof &prof, double tp_total){
+    Tprof prof_now = prof;
+    prof_add(prof_now, prof_now.t_total, tp_total);
+    put_check(bytes, &prof_now, sizeof(Tprof));
+}
+
+
+bool get_prof_state(Tcheck &ck, Tprof &prof){
+    bool on = prof.on;
+    if (!get_check(ck, &prof, sizeof(Tprof))){
+        return false;
+    }
+    prof.on = on;
+    return true;
+}
+
+
+// it copies the state of the integration to a new checkpoint, see Tcheck
+void save_check(Tcheck &ck, Tener_out &fe, Tprof &prof, double tp_total, double t, double dt1, 
+                double dt_min, double e, double ****pcav, double *pi, long N, long M, int K, int nch_exc){
+    string bytes;
+    bytes.reserve(sizeof(Tcheck_header) + (N + M * K * 2 * nch_exc) * sizeof(double) + 4096);
+    put_check(bytes, &ck.header, sizeof(Tcheck_header));
+    double scalars[4] = {t, dt1, dt_min, e};
+    put_check(bytes, scalars, sizeof(scalars));
+    put_ener_state(bytes, fe);
+    put_prof_state(bytes, prof, tp_total);
+    for (long he = 0; he < M; he++){
+        for (int w = 0; w < K; w++){
+            for (int s = 0; s < 2; s++){
+                put_check(bytes, pcav[he][w][s], nch_exc * sizeof(double));
+            }
+        }
+    }
+    put_check(bytes, pi, N * sizeof(double));
+    start_check(ck, bytes);
+}
+
+
+bool load_check(Tcheck &ck, Tener_out &fe, Tprof &prof, double &t, double &dt1, double &dt_min, 
+                double &e, double ****pcav, double *pi, long N, long M, int K, int nch_exc){
+    double scalars[4];
+    if (!get_check(ck, scalars, sizeof(scalars)) || !get_ener_state(ck, fe) || !get_prof_state(ck, prof)){
+        return false;
+    }
+    t = scalars[0];
+    dt1 = scalars[1];
+    dt_min = scalars[2];
+    e = scalars[3];
+    for (long he = 0; he < M; he++){
+        for (int w = 0; w < K; w++){
+            for (int s = 0; s < 2; s++){
+                if (!get_check(ck, pcav[he][w][s], nch_exc * sizeof(double))){
+                    return false;
+                }
+            }
+        }
+    }
+    if (!get_check(ck, pi, N * sizeof(double))){
+        return false;
+    }
+    bool complete = (ck.pos == ck.saved.size());
+    string().swap(ck.saved);
+    return complete;
+}
+
+
 // peforms the integration of the differential equations with the 2nd order Runge-Kutta
 // the method is implemented with adaptive step size
-void RK2_walksat(Tnode *nodes, Thedge *hedges, long N, long M, int K, int nch_fn, double q, 
-                 int max_c, double p0, char *fileener, double tl, double tol = 1e-2, 
+// It returns false if the checkpoint to resume from cannot be read
+bool RK2_walksat(Tnode *nodes, Thedge *hedges, long N, long M, int K, int nch_fn, double q, 
+                 int max_c, double p0, Tener_out &fe, double tl, bool prof_on, Tcheck &ck, double tol = 1e-2, 
                  double t0 = 0, double dt0 = 0.01, double ef = 1e-6, double dt_min = 1e-7){
     double *poisson_probs, *poisson_sums;
     double ****pcav, ***pu_cav, ****cme_sum, *pi, *me_sum, ***sums_save;
@@ -908,16 +1583,27 @@ void RK2_walksat(Tnode *nodes, Thedge *hedges, long N, long M, int K, int nch_fn
     double ****k1c, ****k2c, ****pcav_1, *k1, *k2, *pi_1;
     init_RK_arr(k1c, k2c, pcav_1, k1, k2, pi_1, N, M, K, nch_fn / 2);
 
-    ofstream fe(fileener);
-    
-    get_pu_cav(pcav, pu_cav, hedges, M, K);
-    e = energy(pu_cav, pi, hedges, M);
-    pu_av = e / M;
-    fe << t0 << "\t" << e / N << endl;   // it prints the energy density
 
+    Tprof prof;
+    init_prof(prof, prof_on);
+    double tp, tp_stage;
+    double tp_total = prof_time(prof);
+    
     double dt1 = dt0;
     double t = t0;
 
+    if (ck.resumed){
+        if (!load_check(ck, fe, prof, t, dt1, dt_min, e, pcav, pi, N, M, K, nch_fn / 2)){
+            return false;
+        }
+        get_pu_cav(pcav, pu_cav, hedges, M, K);
+    }else{
+        get_pu_cav(pcav, pu_cav, hedges, M, K);
+        e = energy(pu_cav, pi, hedges, M);
+        add_ener(fe, t0, e / N, 0);   // it prints the energy density
+    }
+    pu_av = e / M;
+
     bool valid;
 
     // the time scale is already given in Monte Carlo steps. Inside the rates I am using 
@@ -928,13 +1614,21 @@ void RK2_walksat(Tnode *nodes, Thedge *hedges, long N, long M, int K, int nch_fn
             break;
         }
 
-        auto t1 = std::chrono::high_resolution_clock::now();
+        if (check_due(ck)){
+            save_check(ck, fe, prof, tp_total, t, dt1, dt_min, e, pcav, pi, N, M, K, nch_fn / 2);
+        }
 
+        tp = prof_time(prof);
         get_all_poisson_sums(max_c, pu_av, poisson_probs, poisson_sums, mean_c);
+        prof_add(prof, prof.t_cond, tp);
 
+        tp = prof_time(prof);
         der_fms(nodes, hedges, pcav, pu_cav, pi, poisson_probs, poisson_sums, N, M, K, nch_fn, e / N, cme_sum, 
                 me_sum, sums_save, q);   // in the rates, I use the energy density
+        prof_add(prof, prof.t_der, tp);
+        prof.nder++;
 
+        tp_stage = prof_time(prof);
         valid = true;
         for (long he = 0; he < M; he++){
             for (int w = 0; w < K; w++){
@@ -963,6 +1657,7 @@ void RK2_walksat(Tnode *nodes, Thedge *hedges, long N, long M, int K, int nch_fn
         while (!valid){
             //  cout << "some probabilities became negative in the auxiliary step of RK2" << endl;
             dt1 /= 2;
+            prof.nhalf++;
             //  cout << "step divided by half    dt=" << dt1 << endl;
             if (dt1 < dt_min){
                 dt_min /= 2;
@@ -994,16 +1689,28 @@ void RK2_walksat(Tnode *nodes, Thedge *hedges, long N, long M, int K, int nch_fn
                 }
             }
         }
+        prof_add(prof, prof.t_stage1, tp_stage);
 
+        tp = prof_time(prof);
         get_pu_cav(pcav_1, pu_cav, hedges, M, K);
+        prof_add(prof, prof.t_cond, tp);
+
+        tp = prof_time(prof);
         e = energy(pu_cav, pi_1, hedges, M);
         pu_av = e / M;
+        prof_add(prof, prof.t_energy, tp);
 
+        tp = prof_time(prof);
         get_all_poisson_sums(max_c, pu_av, poisson_probs, poisson_sums, mean_c);
+        prof_add(prof, prof.t_cond, tp);
 
+        tp = prof_time(prof);
         der_fms(nodes, hedges, pcav_1, pu_cav, pi_1, poisson_probs, poisson_sums, N, M, K, nch_fn, e / N, cme_sum, 
                 me_sum, sums_save, q);
+        prof_add(prof, prof.t_der, tp);
+        prof.nder++;
 
+        tp_stage = prof_time(prof);
         valid = true;
         for (long he = 0; he < M; he++){
             for (int w = 0; w < K; w++){
@@ -1030,6 +1737,7 @@ void RK2_walksat(Tnode *nodes, Thedge *hedges, long N, long M, int K, int nch_fn
         if (!valid){
             //  cout << "Some probabilities would be negative if dt=" << dt1 << " is taken" << endl;
             dt1 /= 2;
+            prof.nhalf++;
             //  cout << "step divided by half    dt=" << dt1  << endl;
             if (dt1 < dt_min){
                 dt_min /= 2;
@@ -1060,6 +1768,8 @@ void RK2_walksat(Tnode *nodes, Thedge *hedges, long N, long M, int K, int nch_fn
                 //  cout << "step dt=" << dt1 << "  accepted" << endl;
                 //  cout << "error=" << error << endl;
                 t += dt1;
+                prof.naccept++;
+                prof_dt(prof, dt1);
 
                 for (long he = 0; he < M; he++){
                     for (int w = 0; w < K; w++){
@@ -1079,9 +1789,10 @@ void RK2_walksat(Tnode *nodes, Thedge *hedges, long N, long M, int K, int nch_fn
                 get_pu_cav(pcav, pu_cav, hedges, M, K);
                 e = energy(pu_cav, pi, hedges, M);
                 pu_av = e / M;
-                fe << t << "\t" << e / N << endl;
+                add_ener(fe, t, e / N, dt1);
 
             }else{
+                prof.nreject++;
                 get_pu_cav(pcav, pu_cav, hedges, M, K);
                 e = energy(pu_cav, pi, hedges, M);
                 pu_av = e / M;
@@ -1098,15 +1809,17 @@ void RK2_walksat(Tnode *nodes, Thedge *hedges, long N, long M, int K, int nch_fn
 
             //  cout << "Recommended step is dt=" << dt1 << endl;
         }
-
-        auto t2 = std::chrono::high_resolution_clock::now();
-
-        auto ms_int = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1);
-
-        // cout << "iteration time:   " << ms_int.count() << "ms" << endl; 
+        prof_add(prof, prof.t_stage2, tp_stage);
     }
 
-    fe.close();
+    wait_check(ck);
+    prof_add(prof, prof.t_total, tp_total);
+    if (prof.on){
+        ostringstream sprof;
+        print_prof(sprof, prof);
+        fe.info = sprof.str();
+    }
+    return true;
 
 }
 
@@ -1120,6 +1833,34 @@ int main(int argc, char *argv[]) {
     double tl = atof(argv[6]);
     double tol = atof(argv[7]);
     int nthr = atoi(argv[8]);
+    bool prof_on = false;
+    if (argc > 9){
+        prof_on = (atoi(argv[9]) != 0);
+    }
+    char *filegraph_bin = NULL;   // binary graph file, see Graph_to_binary.cpp
+    if (argc > 10 && string(argv[10]) != "-"){
+        filegraph_bin = argv[10];
+    }
+    int ener_format = 0;    // 0: text, 1: binary file, 2: container (see Tener_out)
+    if (argc > 11){
+        ener_format = atoi(argv[11]);
+    }
+    int ener_nlog = 0;      // points per decade of time, 0 keeps all the points
+    if (argc > 12){
+        ener_nlog = atoi(argv[12]);
+    }
+    char *filecont = NULL;
+    if (argc > 13){
+        filecont = argv[13];
+    }
+    double check_s = 0;     // wall seconds between checkpoints, 0 writes none (see Tcheck)
+    if (argc > 14){
+        check_s = atof(argv[14]);
+    }
+    bool resume = false;
+    if (argc > 15){
+        resume = (atoi(argv[15]) != 0);
+    }
 
     int nch_fn = (1 << K);
     double p0 = 0.5;
@@ -1140,17 +1881,50 @@ int main(int argc, char *argv[]) {
     //                    K, N, M);
 
     char fileener[300]; 
+    int64_t graph_size = 0;     // the checkpoints only resume on the same graph
+    uint64_t graph_hash = 0;
     sprintf(fileener, "CME_WalkSAT_av_rates_ener_K_%d_N_%li_M_%li_q_%.4lf_tl_%.2lf_seed_%li_tol_%.1e.txt", 
             K, N, M, q, tl, seed_r, tol);
 
-    create_graph(N, M, K, nodes, hedges, r);
+    if (filegraph_bin != NULL){
+        long N_file, M_file;
+        int K_file;
+        if (!read_graph_bin(filegraph_bin, N_file, M_file, K_file, nodes, hedges, graph_size, graph_hash) || N_file != N || 
+            M_file != M || K_file != K){
+            cout << "Cannot read the graph " << filegraph_bin << " with N=" << N << " M=" << M << " K=" << K 
+                 << endl;
+            return 1;
+        }
+    }else{
+        create_graph(N, M, K, nodes, hedges, r);
+    }
     // read_graph_old_order(filegraph, N, M, K, nodes, hedges);
     // read_links(filelinks, N, M, K, nodes, hedges);
     int max_c = get_max_c(nodes, N);
     get_info_exc(nodes, hedges, N, M, K, nch_fn);
 
     
-    RK2_walksat(nodes, hedges, N, M, K, nch_fn, q, max_c, p0, fileener, tl, tol);
+    Tcheck check;
+    init_check(check, fileener, check_s, N, M, K, nch_fn, q, tol, graph_size, graph_hash);
+    if (resume && !read_check(check)){
+        cout << "The checkpoint " << check.file << " is not from a run with these parameters and graph" << endl;
+        return 1;
+    }
+
+    Tener_out fener;
+    if (!open_ener(fener, fileener, ener_format, ener_nlog, filecont, check.resumed)){
+        cout << "Cannot open the output of the energy " << fileener << endl;
+        return 1;
+    }
+    if (!RK2_walksat(nodes, hedges, N, M, K, nch_fn, q, max_c, p0, fener, tl, prof_on, check, tol)){
+        cout << "Cannot resume from the checkpoint " << check.file << endl;
+        return 1;
+    }
+    if (!close_ener(fener)){
+        cout << "Cannot write the energy " << fileener << endl;
+        return 1;
+    }
+    end_check(check);
 
     return 0;
 }
\ No newline at end of file
@@ -1,10 +1,16 @@
 #include <iostream>
 #include <fstream>
 #include <map>
+#include <string>
 #include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
 #include <vector>
 #include <gsl/gsl_randist.h>
 #include <gsl/gsl_cdf.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace std;
 
@@ -77,15 +83,165 @@ long create_graph(long N, long M, int K, Thedge *&hedges, gsl_rng * r, long *&di
 }
 
 
-void PrintToInput(Thedge *hedges, long N, long M, long *disc_before, long ndisc){
-    cout << "p" << "\t" << "cnf" << "\t" << N - ndisc << "\t" << M << endl;
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC11). The output is a
+// pure function of the counter and the key, so any clause can be generated alone
+void philox4x32(uint32_t ctr[4], uint32_t key[2], uint32_t out[4]){
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    uint64_t p0, p1;
+    for (int round = 0; round < 10; round++){
+        p0 = (uint64_t) 0xD2511F53 * c0;
+        p1 = (uint64_t) 0xCD9E8D57 * c2;
+        c0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t) p1;
+        c2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t) p0;
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+
+// stream of numbers of one clause: the key is the seed and the counter (he, j), with j = 0, 1, ...
+typedef struct{
+    uint32_t ctr[4];
+    uint32_t key[2];
+    uint32_t buf[4];
+    int used;
+}Tphilox;
+
+
+void philox_init(Tphilox &g, unsigned long seed, long he){
+    g.key[0] = (uint32_t) seed;
+    g.key[1] = (uint32_t) ((uint64_t) seed >> 32);
+    g.ctr[0] = (uint32_t) he;
+    g.ctr[1] = (uint32_t) ((uint64_t) he >> 32);
+    g.ctr[2] = 0;
+    g.ctr[3] = 0;
+    g.used = 4;
+}
+
+
+uint32_t philox_next(Tphilox &g){
+    if (g.used == 4){
+        philox4x32(g.ctr, g.key, g.buf);
+        g.ctr[2]++;
+        g.used = 0;
+    }
+    return g.buf[g.used++];
+}
+
+
+// uniform integer in [0, n) without bias (Lemire's multiply and reject), for 0 < n < 2^32
+uint32_t philox_uniform(Tphilox &g, uint32_t n){
+    uint64_t m = (uint64_t) philox_next(g) * n;
+    uint32_t l = (uint32_t) m;
+    if (l < n){
+        uint32_t t = -n % n;
+        while (l < t){
+            m = (uint64_t) philox_next(g) * n;
+            l = (uint32_t) m;
+        }
+    }
+    return m >> 32;
+}
+
+
+// clause he has K different variables with random links, as in create_graph, but taken from its own stream
+void philox_clause(unsigned long seed, long he, long N, int K, long *nodes_in, int *links){
+    Tphilox g;
+    philox_init(g, seed, he);
+    int w = 0;
+    long var;
+    bool cond;
+    while (w < K){
+        var = philox_uniform(g, N);
+        cond = true;
+        for (int h = 0; h < w && cond; h++){
+            if (nodes_in[h] == var){
+                cond = false;
+            }
+        }
+        if (cond){
+            nodes_in[w] = var;
+            links[w] = (philox_next(g) & 1) ? 1 : -1;
+            w++;
+        }
+    }
+}
+
+
+// the same graph as 'Graph_to_binary.out philox N M K seed', with the clauses made in parallel
+long create_graph_philox(long N, long M, int K, unsigned long seed, Thedge *&hedges, long *&disc_before){
+    disc_before = new long [N];
+    init_graph(hedges, M);
+    #pragma omp parallel for schedule(static)
+    for (long he = 0; he < M; he++){
+        hedges[he].nodes_in.resize(K);
+        hedges[he].links.resize(K);
+        philox_clause(seed, he, N, K, hedges[he].nodes_in.data(), hedges[he].links.data());
+    }
+
+    vector <bool> used(N, false);
+    for (long he = 0; he < M; he++){
+        for (int w = 0; w < K; w++){
+            used[hedges[he].nodes_in[w]] = true;
+        }
+    }
+    long counter = 0;
+    for (long i = 0; i < N; i++){
+        disc_before[i] = counter;
+        if (!used[i]){
+            counter++;
+        }
+    }
+    return counter;
+}
+
+
+// the stream is flushed only at the end, not after every clause
+void PrintToInput(Thedge *hedges, long N, long M, long *disc_before, long ndisc, ostream &out){
+    out << "p" << "\t" << "cnf" << "\t" << N - ndisc << "\t" << M << "\n";
     for (long he = 0; he < M; he++){
         for (int w = 0; w < hedges[he].nodes_in.size(); w++){
-            cout << (hedges[he].nodes_in[w] - disc_before[hedges[he].nodes_in[w]] + 1) * 
+            out << (hedges[he].nodes_in[w] - disc_before[hedges[he].nodes_in[w]] + 1) * 
                     hedges[he].links[w] << "\t";
         }
-        cout << 0 << endl;
+        out << 0 << "\n";
+    }
+    out.flush();
+}
+
+
+// it writes the binary format read by wfacwsat.c:
+// "BCNF", int32 numatom, int32 numclause, int64 numliterals, int32 sizes[numclause],
+// int32 literals[numliterals], in the byte order of the machine
+void PrintToBinary(Thedge *hedges, long N, long M, long *disc_before, long ndisc, FILE *out){
+    int32_t header[2] = {(int32_t) (N - ndisc), (int32_t) M};
+    int64_t nlits = 0;
+    vector <int32_t> sizes(M);
+    for (long he = 0; he < M; he++){
+        sizes[he] = hedges[he].nodes_in.size();
+        nlits += sizes[he];
+    }
+    vector <int32_t> lits(nlits);
+    long pos = 0;
+    for (long he = 0; he < M; he++){
+        for (int w = 0; w < hedges[he].nodes_in.size(); w++){
+            lits[pos++] = (hedges[he].nodes_in[w] - disc_before[hedges[he].nodes_in[w]] + 1) * 
+                          hedges[he].links[w];
+        }
     }
+    fwrite("BCNF", 1, 4, out);
+    fwrite(header, sizeof(int32_t), 2, out);
+    fwrite(&nlits, sizeof(int64_t), 1, out);
+    fwrite(sizes.data(), sizeof(int32_t), M, out);
+    fwrite(lits.data(), sizeof(int32_t), nlits, out);
+    fflush(out);
 }
 
 
@@ -95,16 +251,58 @@ int main(int argc, char *argv[]) {
     long M = atol(argv[2]);
     int K = atoi(argv[3]);
     unsigned long seed = atol(argv[4]);
+    int format = 0;        // 0: DIMACS, 1: binary
+    if (argc > 5){
+        format = atoi(argv[5]);
+    }
+    char *fileout = NULL;  // the formula goes to stdout if no file is given
+    if (argc > 6 && string(argv[6]) != "-"){
+        fileout = argv[6];
+    }
+    int gen = 0;           // 0: GSL, as the CDA and CME programs, 1: Philox, see Graph_to_binary.cpp
+    if (argc > 7){
+        gen = atoi(argv[7]);
+    }
 
     Thedge *hedges;
 
-    gsl_rng * r;
-    init_ran(r, seed);
-
     long *disc_before;
-    long ndisc = create_graph(N, M, K, hedges, r, disc_before);
+    long ndisc;
+    if (gen == 1){
+        if (N <= 0 || N > 4294967295L || K > N){
+            cerr << "Philox needs K <= N < 2^32" << endl;
+            return 1;
+        }
+        ndisc = create_graph_philox(N, M, K, seed, hedges, disc_before);
+    }else{
+        gsl_rng * r;
+        init_ran(r, seed);
+        ndisc = create_graph(N, M, K, hedges, r, disc_before);
+    }
 
-    PrintToInput(hedges, N, M, disc_before, ndisc);
+    if (format == 1){
+        FILE *out = stdout;
+        if (fileout != NULL){
+            out = fopen(fileout, "wb");
+            if (out == NULL){
+                cerr << "Cannot open " << fileout << endl;
+                return 1;
+            }
+        }
+        PrintToBinary(hedges, N, M, disc_before, ndisc, out);
+        if (fileout != NULL){
+            fclose(out);
+        }
+    }else{
+        ios::sync_with_stdio(false);
+        if (fileout != NULL){
+            ofstream fout(fileout);
+            PrintToInput(hedges, N, M, disc_before, ndisc, fout);
+            fout.close();
+        }else{
+            PrintToInput(hedges, N, M, disc_before, ndisc, cout);
+        }
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,507 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_cdf.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+// It writes a K-SAT instance in the binary graph format that CDA_FMS.cpp, CME_FMS.cpp,
+// CDA_WalkSAT_av_rates.cpp, CME_WalkSAT_av_rates.cpp and CDA_decimation_FMS.cpp map in memory
+// (function read_graph_bin). The instance can be:
+//   random N M K seed fileout -> the graph that those programs build with create_graph and that seed
+//   dimacs filecnf fileout -> a DIMACS file, where all the clauses must have the same number of literals
+//   text filegraph filelinks N M K fileout -> the old text files of read_graph_old_order and read_links
+//   philox N M K seed fileout [nthr] -> a random graph where clause he depends only on (seed, he), made
+//                                       in parallel with nthr threads. The file does not depend on nthr
+//
+// Format (version 1), in the byte order of the machine:
+//   header: char "AMEG", int32 version, int32 K, int32 0, int64 N, int64 M
+//   int64 clause_nodes[M * K]    nodes of each clause
+//   int64 node_start[N + 1]      the clauses of node i are node_fn[node_start[i]...node_start[i + 1] - 1]
+//   int64 node_fn[M * K]
+//   int32 node_pos[M * K]        position of the node inside each of those clauses
+//   int8 clause_links[M * K]     links (1 or -1) of the nodes of each clause
+// The int64 arrays start at a multiple of 8 bytes. node_pos ends at a multiple of 4, so clause_links, which
+// is read byte by byte, starts at an odd multiple of 4 when M * K is odd.
+
+void init_ran(gsl_rng * &r, unsigned long s){
+    const gsl_rng_type * T;
+    gsl_rng_env_setup();
+    T = gsl_rng_default;
+    r = gsl_rng_alloc(T);
+    gsl_rng_set(r, s);
+}
+
+
+typedef struct{
+    vector <long> nodes_in;  // nodes inside the factor node
+    vector <int> links;
+}Thedge;
+
+
+typedef struct{
+    vector <long> fn_in;  // factor nodes of the node, in the order used by the programs
+    vector <int> pos_fn;  // position of the node in each of them
+}Tnode;
+
+
+// the arrays of the file
+typedef struct{
+    long N, M;
+    int K;
+    vector <int64_t> clause_nodes, node_start, node_fn;
+    vector <int32_t> node_pos;
+    vector <int8_t> clause_links;
+}Tgraph_arrays;
+
+
+typedef struct{
+    char magic[4];
+    int32_t version;
+    int32_t K;
+    int32_t unused;
+    int64_t N;
+    int64_t M;
+}Tgraph_header;
+
+
+// the same random graph as create_graph in CDA_FMS.cpp
+void create_graph(long N, long M, int K, Thedge *&hedges, gsl_rng * r){
+    hedges = new Thedge[M];
+    int w, h;
+    long var;
+    bool cond;
+    for (long he = 0; he < M; he++){
+        w = 0;
+        while (w < K){
+            var = gsl_rng_uniform_int(r, N);
+            cond = true;
+            h = 0;
+            while (h < hedges[he].nodes_in.size() && cond){
+                if (hedges[he].nodes_in[h] == var){
+                    cond = false;
+                }
+                h++;
+            }
+
+            if (cond){
+                hedges[he].nodes_in.push_back(var);
+                if (gsl_rng_uniform_pos(r) < 0.5){
+                    hedges[he].links.push_back(1);
+                }else{
+                    hedges[he].links.push_back(-1);
+                }
+                w++;
+            }
+        }
+    }
+}
+
+
+// the lists of the nodes in the order in which create_graph fills them: by increasing clause
+void nodes_from_hedges(Thedge *hedges, long N, long M, Tnode *&nodes){
+    nodes = new Tnode[N];
+    for (long he = 0; he < M; he++){
+        for (int w = 0; w < hedges[he].nodes_in.size(); w++){
+            nodes[hedges[he].nodes_in[w]].fn_in.push_back(he);
+            nodes[hedges[he].nodes_in[w]].pos_fn.push_back(w);
+        }
+    }
+}
+
+
+// it reads a DIMACS file. The literal l is the node |l| - 1 with link sign(l), as written by
+// Graph_to_CNF_input.cpp
+bool read_dimacs(char *filecnf, long &N, long &M, int &K, Thedge *&hedges){
+    ifstream fin(filecnf);
+    if (!fin.is_open()){
+        return false;
+    }
+    string line, p, cnf;
+    N = -1;
+    while (N < 0 && getline(fin, line)){
+        if (line.empty() || line[0] == 'c'){
+            continue;
+        }
+        istringstream sline(line);
+        if (!(sline >> p >> cnf >> N >> M) || p != "p" || cnf != "cnf"){
+            return false;
+        }
+    }
+    if (N < 0){
+        return false;
+    }
+
+    hedges = new Thedge[M];
+    K = 0;
+    long he = 0, lit;
+    while (he < M && fin >> lit){
+        if (lit == 0){
+            if (K == 0){
+                K = hedges[he].nodes_in.size();
+            }
+            if (hedges[he].nodes_in.size() != K){
+                cerr << "Clause " << he << " does not have " << K << " literals" << endl;
+                return false;
+            }
+            he++;
+        }else{
+            if (labs(lit) > N){
+                return false;
+            }
+            hedges[he].nodes_in.push_back(labs(lit) - 1);
+            hedges[he].links.push_back((lit > 0) ? 1 : -1);
+        }
+    }
+    return he == M;
+}
+
+
+// it reads the old text files as read_graph_old_order and read_links in CDA_FMS.cpp. There, each clause
+// that a node shares with an earlier node is looked for in the list of that node; here it is found in a
+// map from the sorted nodes of the clause
+bool read_text(char *filegraph, char *filelinks, long N, long M, int K, Thedge *&hedges, Tnode *&nodes){
+    ifstream fg(filegraph);
+    ifstream fl(filelinks);
+    if (!fg.is_open() || !fl.is_open()){
+        return false;
+    }
+    hedges = new Thedge[M];
+    nodes = new Tnode[N];
+    map <vector <long>, long> clause_of;
+    string trash_str;
+    double trash_double;
+    int nfacn;
+    vector <long> nodes_in(K);
+    long fn_count = 0;
+    long he;
+    for (long i = 0; i < N; i++){
+        fg >> trash_double;
+        fg >> nfacn;
+        getline(fg, trash_str);
+        getline(fg, trash_str);
+        for (int k = 0; k < nfacn; k++){
+            nodes_in[0] = i;
+            for (int j = 0; j < K - 1; j++){
+                fg >> trash_double;
+                fg >> trash_double;
+                fg >> nodes_in[j + 1];
+                fg >> trash_double;
+                fg >> trash_double;
+            }
+            sort(nodes_in.begin(), nodes_in.end());
+            if (nodes_in[0] == i){
+                if (fn_count >= M){
+                    return false;
+                }
+                he = fn_count;
+                hedges[he].nodes_in = nodes_in;
+                hedges[he].links = vector <int> (K, 0);
+                clause_of.insert(make_pair(nodes_in, he));
+                fn_count++;
+            }else{
+                map <vector <long>, long>::iterator it = clause_of.find(nodes_in);
+                if (it == clause_of.end()){
+                    return false;
+                }
+                he = it->second;
+            }
+            nodes[i].fn_in.push_back(he);
+            nodes[i].pos_fn.push_back(find(nodes_in.begin(), nodes_in.end(), i) - nodes_in.begin());
+        }
+    }
+    if (fn_count != M || !fg){
+        return false;
+    }
+
+    int trash_int, link;
+    for (long i = 0; i < N; i++){
+        fl >> trash_int;
+        for (int hind = 0; hind < nodes[i].fn_in.size(); hind++){
+            fl >> link;
+            hedges[nodes[i].fn_in[hind]].links[nodes[i].pos_fn[hind]] = link;
+        }
+    }
+    return (bool) fl;
+}
+
+
+void arrays_from_graph(Thedge *hedges, Tnode *nodes, long N, long M, int K, Tgraph_arrays &g){
+    long nocc = M * K;
+    g.N = N;
+    g.M = M;
+    g.K = K;
+    g.clause_nodes.resize(nocc);
+    g.clause_links.resize(nocc);
+    g.node_start.resize(N + 1);
+    g.node_fn.resize(nocc);
+    g.node_pos.resize(nocc);
+    for (long he = 0; he < M; he++){
+        for (int w = 0; w < K; w++){
+            g.clause_nodes[he * K + w] = hedges[he].nodes_in[w];
+            g.clause_links[he * K + w] = hedges[he].links[w];
+        }
+    }
+    g.node_start[0] = 0;
+    for (long i = 0; i < N; i++){
+        g.node_start[i + 1] = g.node_start[i] + nodes[i].fn_in.size();
+        for (int k = 0; k < nodes[i].fn_in.size(); k++){
+            g.node_fn[g.node_start[i] + k] = nodes[i].fn_in[k];
+            g.node_pos[g.node_start[i] + k] = nodes[i].pos_fn[k];
+        }
+    }
+}
+
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC11). The output is a
+// pure function of the counter and the key, so any clause can be generated alone
+void philox4x32(uint32_t ctr[4], uint32_t key[2], uint32_t out[4]){
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    uint64_t p0, p1;
+    for (int round = 0; round < 10; round++){
+        p0 = (uint64_t) 0xD2511F53 * c0;
+        p1 = (uint64_t) 0xCD9E8D57 * c2;
+        c0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t) p1;
+        c2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t) p0;
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+
+// stream of numbers of one clause: the key is the seed and the counter (he, j), with j = 0, 1, ...
+typedef struct{
+    uint32_t ctr[4];
+    uint32_t key[2];
+    uint32_t buf[4];
+    int used;
+}Tphilox;
+
+
+void philox_init(Tphilox &g, unsigned long seed, long he){
+    g.key[0] = (uint32_t) seed;
+    g.key[1] = (uint32_t) ((uint64_t) seed >> 32);
+    g.ctr[0] = (uint32_t) he;
+    g.ctr[1] = (uint32_t) ((uint64_t) he >> 32);
+    g.ctr[2] = 0;
+    g.ctr[3] = 0;
+    g.used = 4;
+}
+
+
+uint32_t philox_next(Tphilox &g){
+    if (g.used == 4){
+        philox4x32(g.ctr, g.key, g.buf);
+        g.ctr[2]++;
+        g.used = 0;
+    }
+    return g.buf[g.used++];
+}
+
+
+// uniform integer in [0, n) without bias (Lemire's multiply and reject), for 0 < n < 2^32
+uint32_t philox_uniform(Tphilox &g, uint32_t n){
+    uint64_t m = (uint64_t) philox_next(g) * n;
+    uint32_t l = (uint32_t) m;
+    if (l < n){
+        uint32_t t = -n % n;
+        while (l < t){
+            m = (uint64_t) philox_next(g) * n;
+            l = (uint32_t) m;
+        }
+    }
+    return m >> 32;
+}
+
+
+// clause he has K different variables with random links, as in create_graph, but taken from its own stream
+void philox_clause(unsigned long seed, long he, long N, int K, int64_t *nodes_in, int8_t *links){
+    Tphilox g;
+    philox_init(g, seed, he);
+    int w = 0;
+    long var;
+    bool cond;
+    while (w < K){
+        var = philox_uniform(g, N);
+        cond = true;
+        for (int h = 0; h < w && cond; h++){
+            if (nodes_in[h] == var){
+                cond = false;
+            }
+        }
+        if (cond){
+            nodes_in[w] = var;
+            links[w] = (philox_next(g) & 1) ? 1 : -1;
+            w++;
+        }
+    }
+}
+
+
+// The clauses are generated in parallel. The lists of the nodes are made with a counting sort: the
+// occurrences are counted with atomic additions and put in place with atomic counters, and then each list
+// is sorted, so that it has the clauses in increasing order (as create_graph) whatever the number of threads
+void create_graph_philox(long N, long M, int K, unsigned long seed, Tgraph_arrays &g){
+    long nocc = M * K;
+    g.N = N;
+    g.M = M;
+    g.K = K;
+    g.clause_nodes.resize(nocc);
+    g.clause_links.resize(nocc);
+    g.node_start.assign(N + 1, 0);
+    g.node_fn.resize(nocc);
+    g.node_pos.resize(nocc);
+
+    #pragma omp parallel for schedule(static)
+    for (long he = 0; he < M; he++){
+        philox_clause(seed, he, N, K, &g.clause_nodes[he * K], &g.clause_links[he * K]);
+    }
+
+    #pragma omp parallel for schedule(static)
+    for (long occ = 0; occ < nocc; occ++){
+        #pragma omp atomic
+        g.node_start[g.clause_nodes[occ] + 1]++;
+    }
+    for (long i = 0; i < N; i++){
+        g.node_start[i + 1] += g.node_start[i];
+    }
+
+    // node_fn keeps the occurrence he * K + w until the lists are sorted
+    vector <int64_t> next(g.node_start.begin(), g.node_start.end() - 1);
+    long slot;
+    #pragma omp parallel for schedule(static) private(slot)
+    for (long occ = 0; occ < nocc; occ++){
+        #pragma omp atomic capture
+        slot = next[g.clause_nodes[occ]]++;
+        g.node_fn[slot] = occ;
+    }
+
+    #pragma omp parallel for schedule(dynamic, 4096)
+    for (long i = 0; i < N; i++){
+        sort(g.node_fn.begin() + g.node_start[i], g.node_fn.begin() + g.node_start[i + 1]);
+        for (long k = g.node_start[i]; k < g.node_start[i + 1]; k++){
+            g.node_pos[k] = g.node_fn[k] % K;
+            g.node_fn[k] /= K;
+        }
+    }
+}
+
+
+bool write_graph_bin(char *fileout, Tgraph_arrays &g){
+    Tgraph_header header;
+    memcpy(header.magic, "AMEG", 4);
+    header.version = 1;
+    header.K = g.K;
+    header.unused = 0;
+    header.N = g.N;
+    header.M = g.M;
+
+    long nocc = g.M * g.K;
+    if (g.node_start[g.N] != nocc){
+        return false;
+    }
+
+    FILE *out = fopen(fileout, "wb");
+    if (out == NULL){
+        return false;
+    }
+    fwrite(&header, sizeof(Tgraph_header), 1, out);
+    fwrite(g.clause_nodes.data(), sizeof(int64_t), nocc, out);
+    fwrite(g.node_start.data(), sizeof(int64_t), g.N + 1, out);
+    fwrite(g.node_fn.data(), sizeof(int64_t), nocc, out);
+    fwrite(g.node_pos.data(), sizeof(int32_t), nocc, out);
+    fwrite(g.clause_links.data(), sizeof(int8_t), nocc, out);
+    bool ok = !ferror(out);
+    return (fclose(out) == 0) && ok;
+}
+
+
+
+int main(int argc, char *argv[]) {
+    string mode = (argc > 1) ? argv[1] : "";
+    long N, M;
+    int K;
+    Thedge *hedges;
+    Tnode *nodes;
+    char *fileout;
+    Tgraph_arrays g;
+
+    if (mode == "random" && argc > 6){
+        N = atol(argv[2]);
+        M = atol(argv[3]);
+        K = atoi(argv[4]);
+        unsigned long seed = atol(argv[5]);
+        fileout = argv[6];
+        gsl_rng * r;
+        init_ran(r, seed);
+        create_graph(N, M, K, hedges, r);
+        nodes_from_hedges(hedges, N, M, nodes);
+        arrays_from_graph(hedges, nodes, N, M, K, g);
+    }else if (mode == "philox" && argc > 6){
+        N = atol(argv[2]);
+        M = atol(argv[3]);
+        K = atoi(argv[4]);
+        unsigned long seed = atol(argv[5]);
+        fileout = argv[6];
+        if (N <= 0 || N > 4294967295L || K > N){
+            cerr << "philox needs K <= N < 2^32" << endl;
+            return 1;
+        }
+#ifdef _OPENMP
+        if (argc > 7){
+            omp_set_num_threads(atoi(argv[7]));
+        }
+#endif
+        create_graph_philox(N, M, K, seed, g);
+    }else if (mode == "dimacs" && argc > 3){
+        fileout = argv[3];
+        if (!read_dimacs(argv[2], N, M, K, hedges)){
+            cerr << "Cannot read the DIMACS file " << argv[2] << endl;
+            return 1;
+        }
+        nodes_from_hedges(hedges, N, M, nodes);
+        arrays_from_graph(hedges, nodes, N, M, K, g);
+    }else if (mode == "text" && argc > 7){
+        N = atol(argv[4]);
+        M = atol(argv[5]);
+        K = atoi(argv[6]);
+        fileout = argv[7];
+        if (!read_text(argv[2], argv[3], N, M, K, hedges, nodes)){
+            cerr << "Cannot read the graph " << argv[2] << " with the links " << argv[3] << endl;
+            return 1;
+        }
+        arrays_from_graph(hedges, nodes, N, M, K, g);
+    }else{
+        cerr << "usage: " << argv[0] << " random N M K seed fileout" << endl;
+        cerr << "       " << argv[0] << " dimacs filecnf fileout" << endl;
+        cerr << "       " << argv[0] << " text filegraph filelinks N M K fileout" << endl;
+        cerr << "       " << argv[0] << " philox N M K seed fileout [nthr]" << endl;
+        return 1;
+    }
+
+    if (!write_graph_bin(fileout, g)){
+        cerr << "Cannot write " << fileout << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <stdlib.h>
+#include <stdio.h>
+
+using namespace std;
+
+// It averages the output of wfacwsat.c over all the instances of one (N, alpha, eta), as written by
+// Scripts/run_FMS_KSAT_PD_inner.sh. Each file is read once, line by line, and the running means and
+// variances are updated on the fly (Welford's algorithm), so the memory does not grow with the number
+// of instances or tries.
+
+
+// running mean and variance
+typedef struct{
+    long n;
+    double mean;
+    double m2;
+}Twelford;
+
+
+void add_value(Twelford &w, double x){
+    w.n++;
+    double delta = x - w.mean;
+    w.mean += delta / w.n;
+    w.m2 += delta * (x - w.mean);
+}
+
+
+double get_std(Twelford &w){
+    if (w.n > 1){
+        return sqrt(w.m2 / (w.n - 1));
+    }else{
+        return 0;
+    }
+}
+
+
+string file_name(string path, string prefix, long N, string alpha, int K, int nsamples, int hist, int tl,
+                 string eta, int idgraph){
+    ostringstream name;
+    name << path << prefix << "_K_" << K << "_eta_" << eta << "_N_" << N << "_alpha_" << alpha << "_ngraphs_"
+         << nsamples << "_nhist_" << hist << "_tl_" << tl;
+    if (idgraph > 0){
+        name << "_idgraph_" << idgraph;
+    }
+    name << ".txt";
+    return name.str();
+}
+
+
+// it adds the averaged history of one instance to the statistics of each point. The points that are
+// not in the file come after the last try finished, when all the tries had found a solution
+bool read_history(string filename, vector <Twelford> &ener){
+    ifstream fin(filename.c_str());
+    if (!fin.is_open()){
+        return false;
+    }
+    string line;
+    long t;
+    double e;
+    long point = 0;
+    while (getline(fin, line)){
+        if (line.empty() || line[0] == '#'){
+            continue;
+        }
+        istringstream sline(line);
+        if (sline >> t >> e){
+            if (point < ener.size()){
+                add_value(ener[point], e);
+            }
+            point++;
+        }
+    }
+    for (; point < ener.size(); point++){
+        add_value(ener[point], 0);
+    }
+    fin.close();
+    return true;
+}
+
+
+// it reads the file written with the option -fmin: try, lowest energy, flip of the lowest energy,
+// final energy and number of flips
+bool read_tries(string filename, long N, Twelford &emin, Twelford &efinal, Twelford &tsol, Twelford &psol){
+    ifstream fin(filename.c_str());
+    if (!fin.is_open()){
+        return false;
+    }
+    string line;
+    int ntry;
+    long lowbad, ef;
+    long long lowflip, numflip;
+    while (getline(fin, line)){
+        if (line.empty() || line[0] == '#'){
+            continue;
+        }
+        istringstream sline(line);
+        if (sline >> ntry >> lowbad >> lowflip >> ef >> numflip){
+            add_value(emin, lowbad);
+            add_value(efinal, ef);
+            if (ef == 0){
+                add_value(psol, 1);
+                add_value(tsol, double(numflip) / N);
+            }else{
+                add_value(psol, 0);
+            }
+        }
+    }
+    fin.close();
+    return true;
+}
+
+
+void print_summary(string fileout, vector <Twelford> &ener, long N, long dt, Twelford &emin,
+                   Twelford &efinal, Twelford &tsol, Twelford &psol){
+    ofstream fout(fileout.c_str());
+    fout << "# ninstances=" << (ener.size() > 0 ? ener[0].n : 0) << endl;
+    fout << "# ntries=" << psol.n << endl;
+    fout << "# Psol=" << psol.mean << endl;
+    fout << "# std(Psol)=" << (psol.n > 0 ? sqrt(psol.mean * (1 - psol.mean) / psol.n) : 0) << endl;
+    fout << "# av(tsol)=" << tsol.mean << endl;
+    fout << "# std(tsol)=" << get_std(tsol) << endl;
+    fout << "# av(ef)=" << efinal.mean << endl;
+    fout << "# std(ef)=" << get_std(efinal) << endl;
+    fout << "# av(emin)=" << emin.mean << endl;
+    fout << "# std(emin)=" << get_std(emin) << endl;
+    fout << "# time  av(e)  std(e) over instances  stderr(av(e))" << endl;
+    for (long p = 0; p < ener.size(); p++){
+        double std_e = get_std(ener[p]);
+        fout << double(p * dt) / N << "\t" << ener[p].mean << "\t" << std_e << "\t"
+             << (ener[p].n > 0 ? std_e / sqrt(ener[p].n) : 0) << endl;
+    }
+    fout.close();
+}
+
+
+
+int main(int argc, char *argv[]) {
+    if (argc < 10){
+        cout << "usage: " << argv[0] << " N alpha K nsamples hist iters_save tl eta path" << endl;
+        return 2;
+    }
+    long N = atol(argv[1]);
+    string alpha = argv[2];
+    int K = atoi(argv[3]);
+    int nsamples = atoi(argv[4]);
+    int hist = atoi(argv[5]);
+    long iters_save = atol(argv[6]);
+    int tl = atoi(argv[7]);
+    string eta = argv[8];
+    string path = argv[9];
+
+    vector <Twelford> ener(N * tl / iters_save + 1, Twelford{0, 0, 0});
+    Twelford emin = {0, 0, 0}, efinal = {0, 0, 0}, tsol = {0, 0, 0}, psol = {0, 0, 0};
+
+    for (int id = 1; id <= nsamples; id++){
+        string filehist = file_name(path, "FMS_KSAT", N, alpha, K, nsamples, hist, tl, eta, id);
+        if (!read_history(filehist, ener)){
+            cout << filehist << "  not read" << endl;
+            continue;
+        }
+        string filetries = file_name(path, "FMS_tries", N, alpha, K, nsamples, hist, tl, eta, id);
+        if (!read_tries(filetries, N, emin, efinal, tsol, psol)){
+            cout << filetries << "  not read" << endl;
+        }
+    }
+
+    if (ener[0].n > 0){
+        string fileout = file_name(path, "FMS_summary", N, alpha, K, nsamples, hist, tl, eta, 0);
+        print_summary(fileout, ener, N, iters_save, emin, efinal, tsol, psol);
+    }else{
+        cout << "No data for K=" << K << "  N=" << N << "  eta=" << eta << "  alpha=" << alpha << "  tl=" << tl
+             << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <stdlib.h>
+#include <stdio.h>
+
+using namespace std;
+
+// It compares the output of a run with a reference file, as needed by Scripts/run_regression.sh.
+// Lines that start with '#' are skipped. In the mode 'curve' both files are energy curves (time in the
+// first column, energy in column col), which are compared at every time of both files by linear
+// interpolation. After its last point, a curve is taken as constant, because the programs stop when the
+// energy goes below their threshold. In the mode 'table' the files must have the same numbers in the
+// same places (e.g. the output of CDA_decimation_FMS.cpp).
+// A value e passes if |e - e_ref| <= atol + rtol * |e_ref|. The program prints the largest deviations and
+// returns 0 if all values pass, 1 if some do not and 2 if a file cannot be read.
+
+
+// it reads all the numbers of each line that does not start with '#'
+bool read_table(string filename, vector <vector <double> > &table){
+    ifstream fin(filename.c_str());
+    if (!fin.is_open()){
+        return false;
+    }
+    string line;
+    double x;
+    while (getline(fin, line)){
+        if (line.empty() || line[0] == '#'){
+            continue;
+        }
+        istringstream sline(line);
+        vector <double> row;
+        while (sline >> x){
+            row.push_back(x);
+        }
+        if (!row.empty()){
+            table.push_back(row);
+        }
+    }
+    return true;
+}
+
+
+void get_curve(vector <vector <double> > &table, int col, vector <double> &t, vector <double> &e){
+    for (long i = 0; i < table.size(); i++){
+        if (table[i].size() > col){
+            t.push_back(table[i][0]);
+            e.push_back(table[i][col]);
+        }
+    }
+}
+
+
+// value of the curve at time x. The times are not decreasing, but the programs may print the same time
+// twice, so the first point with t >= x is taken
+double interpolate(vector <double> &t, vector <double> &e, double x){
+    if (x <= t[0]){
+        return e[0];
+    }
+    if (x >= t.back()){
+        return e.back();
+    }
+    long lo = 0, hi = t.size() - 1, mid;
+    while (hi - lo > 1){
+        mid = (lo + hi) / 2;
+        if (t[mid] < x){
+            lo = mid;
+        }else{
+            hi = mid;
+        }
+    }
+    if (t[hi] == t[lo]){
+        return e[hi];
+    }
+    return e[lo] + (e[hi] - e[lo]) * (x - t[lo]) / (t[hi] - t[lo]);
+}
+
+
+typedef struct{
+    long npoints, nfail;
+    double max_abs, max_rel, where;
+}Tdev;
+
+
+void check_value(Tdev &dev, double e, double e_ref, double rtol, double atol, double where){
+    double d = fabs(e - e_ref);
+    dev.npoints++;
+    if (d > atol + rtol * fabs(e_ref)){
+        dev.nfail++;
+    }
+    if (d > dev.max_abs){
+        dev.max_abs = d;
+        dev.where = where;
+    }
+    if (e_ref != 0 && d / fabs(e_ref) > dev.max_rel){
+        dev.max_rel = d / fabs(e_ref);
+    }
+}
+
+
+int main(int argc, char *argv[]) {
+    if (argc < 6){
+        cout << "usage: " << argv[0] << " curve|table file_ref file rtol atol [col]" << endl;
+        return 2;
+    }
+    string mode = argv[1];
+    string fileref = argv[2];
+    string filenew = argv[3];
+    double rtol = atof(argv[4]);
+    double atol = atof(argv[5]);
+    int col = 1;
+    if (argc > 6){
+        col = atoi(argv[6]);
+    }
+
+    vector <vector <double> > table_ref, table_new;
+    if (!read_table(fileref, table_ref) || !read_table(filenew, table_new)){
+        cout << "cannot read " << fileref << " or " << filenew << endl;
+        return 2;
+    }
+
+    Tdev dev = {0, 0, 0, 0, 0};
+    if (mode == "curve"){
+        vector <double> t_ref, e_ref, t_new, e_new;
+        get_curve(table_ref, col, t_ref, e_ref);
+        get_curve(table_new, col, t_new, e_new);
+        if (t_ref.empty() || t_new.empty()){
+            cout << "empty curve" << endl;
+            return 2;
+        }
+        for (long i = 0; i < t_ref.size(); i++){
+            check_value(dev, interpolate(t_new, e_new, t_ref[i]), e_ref[i], rtol, atol, t_ref[i]);
+        }
+        for (long i = 0; i < t_new.size(); i++){
+            check_value(dev, e_new[i], interpolate(t_ref, e_ref, t_new[i]), rtol, atol, t_new[i]);
+        }
+    }else if (mode == "table"){
+        if (table_ref.size() != table_new.size()){
+            cout << "different number of lines: " << table_ref.size() << " " << table_new.size() << endl;
+            return 1;
+        }
+        for (long i = 0; i < table_ref.size(); i++){
+            if (table_ref[i].size() != table_new[i].size()){
+                cout << "different number of columns in line " << i << endl;
+                return 1;
+            }
+            for (int j = 0; j < table_ref[i].size(); j++){
+                check_value(dev, table_new[i][j], table_ref[i][j], rtol, atol, i);
+            }
+        }
+    }else{
+        cout << "unknown mode " << mode << endl;
+        return 2;
+    }
+
+    // 'at' is the time of the largest deviation for curves, and the line for tables
+    cout << "points=" << dev.npoints << " failed=" << dev.nfail << " max_abs_dev=" << dev.max_abs
+         << " max_rel_dev=" << dev.max_rel << " at=" << dev.where << endl;
+
+    return (dev.nfail > 0) ? 1 : 0;
+}
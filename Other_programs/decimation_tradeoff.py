@@ -0,0 +1,74 @@
+__author__ = 'david'
+
+import numpy as np
+import sys
+
+
+# It reads the output of CDA_decimation_FMS.cpp for several seeds and summarizes the
+# success probability against the runtime and the number of integration steps.
+# str_batch is the part of the file name with the batch parameters, for instance
+# '_fdec_0.0500_sched_0_thrdec_1.0000'. It must be an empty string for the default mode.
+def tradeoff(K, N, M, eta, steps_dec, str_batch, tol, seed0, nsamples):
+    solved = 0
+    true_nsamples = 0
+    runtimes = []
+    niters = []
+    nrounds = []
+    for s in range(seed0, seed0 + nsamples):
+        fend = '_K_' + str(K) + '_N_' + str(N) + '_M_' + str(M) + '_eta_' + '%.4lf' % eta + \
+               '_stepsdec_' + str(steps_dec) + str_batch + '_seed_' + str(s) + '_tol_' + '%.1e' % tol + '.txt'
+        try:
+            ffinal = open('CDA_decimation_FMS_final' + fend, "r")
+            lines = ffinal.readlines()
+            ffinal.close()
+            ef, runtime = lines[3].split()
+
+            fdyn = open('CDA_decimation_FMS_dyn' + fend, "r")
+            lines = fdyn.readlines()
+            fdyn.close()
+            line = lines[1].split()
+        except(OSError, IOError, IndexError, ValueError):
+            print('CDA_decimation_FMS_final' + fend + '  not read')
+            continue
+
+        true_nsamples += 1
+        if int(ef) == 0:
+            solved += 1
+        runtimes.append(float(runtime))
+        niters.append(float(line[0]))
+        if len(line) > 2:
+            nrounds.append(float(line[2]))
+        else:
+            nrounds.append(float(N))
+
+    if true_nsamples > 0:
+        print('# Psol  std(Psol)  av(runtime(s))  av(niters)  av(nrounds)  nsamples')
+        psol = float(solved) / true_nsamples
+        print(str(psol) + '\t' + str(np.sqrt(psol * (1 - psol) / true_nsamples)) + '\t' +
+              str(np.mean(runtimes)) + '\t' + str(np.mean(niters)) + '\t' + str(np.mean(nrounds)) + '\t' +
+              str(true_nsamples))
+    else:
+        print('No data for K=' + str(K) + '  N=' + str(N) + '  M=' + str(M) + '  steps_dec=' + str(steps_dec) +
+              str_batch)
+
+
+def main():
+    K = int(sys.argv[1])
+    N = int(sys.argv[2])
+    M = int(sys.argv[3])
+    eta = float(sys.argv[4])
+    steps_dec = int(sys.argv[5])
+    tol = float(sys.argv[6])
+    seed0 = int(sys.argv[7])
+    nsamples = int(sys.argv[8])
+    str_batch = ''
+    if len(sys.argv) > 9:
+        str_batch = sys.argv[9]
+
+    tradeoff(K, N, M, eta, steps_dec, str_batch, tol, seed0, nsamples)
+
+    return 0
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,61 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+// It runs a program and writes its wall time and peak memory to a file, for Scripts/run_regression.sh
+// (the machines where the suite runs do not always have GNU time). Usage:
+//   measure_run.out fileout program [arguments of the program]
+// fileout gets one line 'wall_s=... maxrss_kb=... status=...', where status is the exit status of the
+// program, or 128 + signal if it was killed. The program inherits stdin, stdout and stderr.
+
+
+int main(int argc, char *argv[]) {
+    if (argc < 3){
+        cout << "usage: " << argv[0] << " fileout program [arguments]" << endl;
+        return 2;
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0){
+        perror("fork");
+        return 2;
+    }
+    if (pid == 0){
+        execvp(argv[2], argv + 2);
+        perror(argv[2]);
+        _exit(127);
+    }
+
+    int wstatus;
+    struct rusage usage;
+    if (wait4(pid, &wstatus, 0, &usage) < 0){
+        perror("wait4");
+        return 2;
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    int status;
+    if (WIFEXITED(wstatus)){
+        status = WEXITSTATUS(wstatus);
+    }else{
+        status = 128 + WTERMSIG(wstatus);
+    }
+
+    ofstream fout(argv[1]);
+    // ru_maxrss is in kilobytes on Linux
+    fout << "wall_s=" << std::chrono::duration<double>(t2 - t1).count() << " maxrss_kb=" << usage.ru_maxrss
+         << " status=" << status << endl;
+    fout.close();
+
+    return status;
+}
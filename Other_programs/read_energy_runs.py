@@ -0,0 +1,88 @@
+import numpy as np
+import struct
+import zlib
+import sys
+
+# Reader of the binary energy outputs of CDA_FMS, CME_FMS, CDA_WalkSAT_av_rates and CME_WalkSAT_av_rates
+# (ener_format 1 and 2, see the comment of Tener_out in those programs).
+# Usage:
+#   python read_energy_runs.py file.bin                  prints the run as the text format does
+#   python read_energy_runs.py container                 lists the runs of the container
+#   python read_energy_runs.py container name [fileout]  writes the run 'name' of the container as text
+# From python, load_run(filename) and load_container(filename) return the runs as dictionaries.
+
+header_fmt = '<4siiiqq'
+record_fmt = '<4siiiqq'
+
+
+def parse_run(data):
+    magic, version, ncols, _, npoints, ninfo = struct.unpack_from(header_fmt, data, 0)
+    if magic != b'AMEE' or version != 1:
+        raise ValueError('not an energy run')
+    offset = struct.calcsize(header_fmt)
+    cols = np.frombuffer(data, dtype='<f8', count=ncols * npoints, offset=offset).reshape(ncols, npoints)
+    offset += 8 * ncols * npoints
+    info = data[offset:offset + ninfo].decode()
+    return {'t': cols[0], 'e': cols[1], 'dt': cols[2], 'info': info}
+
+
+def load_run(filename):
+    with open(filename, 'rb') as fin:
+        return parse_run(fin.read())
+
+
+# it returns a dictionary name -> run. If the same name was appended more than once, the last one is kept
+def load_container(filename):
+    runs = {}
+    with open(filename, 'rb') as fin:
+        data = fin.read()
+    offset = 0
+    size = struct.calcsize(record_fmt)
+    while offset + size <= len(data):
+        magic, version, compressed, nname, raw_size, stored_size = struct.unpack_from(record_fmt, data, offset)
+        if magic != b'AMER' or version != 1:
+            raise ValueError('corrupted container at byte ' + str(offset))
+        offset += size
+        name = data[offset:offset + nname].decode()
+        offset += nname
+        stored = data[offset:offset + stored_size]
+        offset += stored_size
+        if compressed:
+            stored = zlib.decompress(stored)
+        if len(stored) != raw_size:
+            raise ValueError('wrong size of the run ' + name)
+        runs[name] = parse_run(stored)
+    return runs
+
+
+def write_text(run, fout):
+    for i in range(len(run['t'])):
+        fout.write('%g\t%g\n' % (run['t'][i], run['e'][i]))
+    fout.write(run['info'])
+
+
+def main():
+    filename = sys.argv[1]
+    with open(filename, 'rb') as fin:
+        magic = fin.read(4)
+    if magic == b'AMEE':
+        write_text(load_run(filename), sys.stdout)
+    elif magic == b'AMER':
+        runs = load_container(filename)
+        if len(sys.argv) > 2:
+            run = runs[sys.argv[2]]
+            if len(sys.argv) > 3:
+                fout = open(sys.argv[3], 'w')
+                write_text(run, fout)
+                fout.close()
+            else:
+                write_text(run, sys.stdout)
+        else:
+            for name in runs:
+                print(name + '\tpoints=' + str(len(runs[name]['t'])))
+    else:
+        print(filename + ' is not a binary energy file')
+
+
+if __name__ == '__main__':
+    main()
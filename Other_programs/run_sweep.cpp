@@ -0,0 +1,417 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <stdlib.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+// It runs all the jobs of a grid of parameters, as many at the same time as the cores and the memory
+// allow, instead of launching every job with '&' as the scripts in Scripts/ do. Usage:
+//   run_sweep.out filesweep journal [ncores] [mem_mb]
+// ncores (default: the cores this process may use) is the number of cores given to the jobs, and mem_mb
+// (default: the physical memory) the memory in megabytes. A job starts when it has 'threads' free cores
+// and 'mem_mb' free memory. It is pinned to its cores, and OMP_NUM_THREADS and OMP_PROC_BIND are set if
+// they are not set already. Pending jobs that fit are started in the order of the grid, so small jobs fill
+// the cores left by large ones. A job larger than the whole machine runs alone.
+// Every job that ends gets a line 'status=... wall_s=... maxrss_kb=...<TAB>command' in the journal. When
+// the sweep is run again with the same journal, the jobs that ended with status 0 are skipped, so a sweep
+// that was stopped goes on from where it was (together with the checkpoints of the programs, see resume
+// in README.md). The program returns 1 if some job failed.
+//
+// The file of the sweep has one keyword per line ('#' starts a comment):
+//   command <template>   program and arguments, separated by spaces
+//   threads <n>          cores of each job (default 1), also available as {threads}
+//   mem_mb <template>    estimate of the memory of each job in megabytes (default 0)
+//   stdout <template>    file for the standard output of each job (default /dev/null)
+//   stderr <template>    file for the standard error of each job (default: the one of run_sweep)
+//   param <name> <v1> <v2> ...       values of a parameter
+//   range <name> <from> <to> <step>  values from, from + step, ... up to to
+// The grid has all the combinations of the parameters, the first one varying slowest. In the templates,
+// {name} is the value of a parameter as written, and {a*b*...} the product of parameters and numbers,
+// rounded to the nearest integer (e.g. {N*alpha} for the number of clauses). In mem_mb the product is not
+// rounded. See Scripts/sweep_*.txt.
+
+
+typedef struct{
+    string name;
+    vector <string> values;
+}Tparam;
+
+
+typedef struct{
+    string command;
+    string fileout, fileerr;
+    double mem_mb;
+    bool done, running;
+    pid_t pid;
+    vector <int> cores;
+    double t_start;
+}Tjob;
+
+
+typedef struct{
+    string command, mem_mb, fileout, fileerr;
+    int threads;
+    vector <Tparam> params;
+}Tsweep;
+
+
+double now_s(){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+string num_str(double x, bool round_int){
+    char str[50];
+    if (round_int){
+        sprintf(str, "%.0lf", floor(x + 0.5));
+    }else{
+        sprintf(str, "%.10g", x);
+    }
+    return string(str);
+}
+
+
+// it replaces every {...} of the template. It returns false if a name is not a parameter
+bool substitute(string tmpl, map <string, string> &vals, bool round_int, string &out){
+    out = "";
+    size_t pos = 0, open, close;
+    while ((open = tmpl.find('{', pos)) != string::npos){
+        close = tmpl.find('}', open);
+        if (close == string::npos){
+            return false;
+        }
+        out += tmpl.substr(pos, open - pos);
+        string expr = tmpl.substr(open + 1, close - open - 1);
+        if (expr.find('*') == string::npos){
+            if (vals.find(expr) == vals.end()){
+                cout << "unknown parameter " << expr << endl;
+                return false;
+            }
+            out += vals[expr];
+        }else{
+            double prod = 1;
+            string factor;
+            istringstream sexpr(expr);
+            while (getline(sexpr, factor, '*')){
+                if (vals.find(factor) != vals.end()){
+                    prod *= atof(vals[factor].c_str());
+                }else{
+                    char *end;
+                    double x = strtod(factor.c_str(), &end);
+                    if (factor.empty() || *end != '\0'){
+                        cout << "unknown parameter " << factor << endl;
+                        return false;
+                    }
+                    prod *= x;
+                }
+            }
+            out += num_str(prod, round_int);
+        }
+        pos = close + 1;
+    }
+    out += tmpl.substr(pos);
+    return true;
+}
+
+
+bool read_sweep(char *filesweep, Tsweep &sw){
+    ifstream fin(filesweep);
+    if (!fin.is_open()){
+        cout << "cannot read " << filesweep << endl;
+        return false;
+    }
+    sw.threads = 1;
+    sw.mem_mb = "0";
+    sw.fileout = "/dev/null";
+    string line, key, rest;
+    while (getline(fin, line)){
+        size_t hash = line.find('#');
+        if (hash != string::npos){
+            line = line.substr(0, hash);
+        }
+        istringstream sline(line);
+        if (!(sline >> key)){
+            continue;
+        }
+        getline(sline >> ws, rest);
+        if (key == "command"){
+            sw.command = rest;
+        }else if (key == "threads"){
+            sw.threads = atoi(rest.c_str());
+        }else if (key == "mem_mb"){
+            sw.mem_mb = rest;
+        }else if (key == "stdout"){
+            sw.fileout = rest;
+        }else if (key == "stderr"){
+            sw.fileerr = rest;
+        }else if (key == "param" || key == "range"){
+            Tparam par;
+            istringstream srest(rest);
+            srest >> par.name;
+            if (key == "param"){
+                string v;
+                while (srest >> v){
+                    par.values.push_back(v);
+                }
+            }else{
+                double from, to, step;
+                if (!(srest >> from >> to >> step) || step <= 0){
+                    cout << "wrong range " << rest << endl;
+                    return false;
+                }
+                for (long i = 0; from + i * step <= to + 1e-9 * step; i++){
+                    par.values.push_back(num_str(from + i * step, false));
+                }
+            }
+            if (par.values.empty()){
+                cout << "no values for " << par.name << endl;
+                return false;
+            }
+            sw.params.push_back(par);
+        }else{
+            cout << "unknown keyword " << key << endl;
+            return false;
+        }
+    }
+    if (sw.command.empty() || sw.threads < 1){
+        cout << "the sweep needs a command and threads >= 1" << endl;
+        return false;
+    }
+    return true;
+}
+
+
+// it builds the jobs of all the combinations of the parameters
+bool make_jobs(Tsweep &sw, vector <Tjob> &jobs){
+    long njobs = 1;
+    for (int p = 0; p < sw.params.size(); p++){
+        njobs *= sw.params[p].values.size();
+    }
+    map <string, string> vals;
+    vals["threads"] = num_str(sw.threads, true);
+    for (long j = 0; j < njobs; j++){
+        long rest = j;
+        for (int p = sw.params.size() - 1; p >= 0; p--){
+            long nv = sw.params[p].values.size();
+            vals[sw.params[p].name] = sw.params[p].values[rest % nv];
+            rest /= nv;
+        }
+        Tjob job;
+        string mem;
+        if (!substitute(sw.command, vals, true, job.command) || !substitute(sw.mem_mb, vals, false, mem) ||
+            !substitute(sw.fileout, vals, true, job.fileout) || !substitute(sw.fileerr, vals, true, job.fileerr)){
+            return false;
+        }
+        job.mem_mb = atof(mem.c_str());
+        job.done = false;
+        job.running = false;
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+
+// it marks as done the jobs that ended with status 0 in an earlier run of the sweep
+void read_journal(char *filejournal, vector <Tjob> &jobs){
+    set <string> done;
+    ifstream fin(filejournal);
+    string line;
+    while (getline(fin, line)){
+        size_t tab = line.find('\t');
+        if (tab != string::npos && line.compare(0, 9, "status=0 ") == 0){
+            done.insert(line.substr(tab + 1));
+        }
+    }
+    for (long j = 0; j < jobs.size(); j++){
+        jobs[j].done = (done.count(jobs[j].command) > 0);
+    }
+}
+
+
+void start_job(Tjob &job, int threads){
+    vector <string> args;
+    string arg;
+    istringstream scommand(job.command);
+    while (scommand >> arg){
+        args.push_back(arg);
+    }
+
+    job.t_start = now_s();
+    job.pid = fork();
+    if (job.pid < 0){
+        perror("fork");
+        return;
+    }
+    if (job.pid == 0){
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c = 0; c < job.cores.size(); c++){
+            CPU_SET(job.cores[c], &set);
+        }
+        sched_setaffinity(0, sizeof(cpu_set_t), &set);
+        setenv("OMP_NUM_THREADS", num_str(threads, true).c_str(), 0);
+        setenv("OMP_PROC_BIND", "close", 0);
+
+        int fd = open(job.fileout.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0){
+            dup2(fd, 1);
+            close(fd);
+        }
+        if (!job.fileerr.empty()){
+            fd = open(job.fileerr.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd >= 0){
+                dup2(fd, 2);
+                close(fd);
+            }
+        }
+
+        vector <char *> argv;
+        for (int a = 0; a < args.size(); a++){
+            argv.push_back(&args[a][0]);
+        }
+        argv.push_back(NULL);
+        execvp(argv[0], argv.data());
+        perror(argv[0]);
+        _exit(127);
+    }
+    job.running = true;
+}
+
+
+int main(int argc, char *argv[]) {
+    if (argc < 3){
+        cout << "usage: " << argv[0] << " filesweep journal [ncores] [mem_mb]" << endl;
+        return 2;
+    }
+
+    // the cores are taken from the ones this process may use
+    cpu_set_t allowed;
+    vector <int> cpus;
+    sched_getaffinity(0, sizeof(cpu_set_t), &allowed);
+    for (int c = 0; c < CPU_SETSIZE; c++){
+        if (CPU_ISSET(c, &allowed)){
+            cpus.push_back(c);
+        }
+    }
+    int ncores = cpus.size();
+    if (argc > 3 && atoi(argv[3]) > 0 && atoi(argv[3]) < ncores){
+        ncores = atoi(argv[3]);
+    }
+    cpus.resize(ncores);
+    double mem_total = (double) sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGE_SIZE) / 1048576;
+    if (argc > 4){
+        mem_total = atof(argv[4]);
+    }
+
+    Tsweep sw;
+    vector <Tjob> jobs;
+    if (!read_sweep(argv[1], sw) || !make_jobs(sw, jobs)){
+        return 2;
+    }
+    read_journal(argv[2], jobs);
+    ofstream fjournal(argv[2], ios::app);
+    if (!fjournal.is_open()){
+        cout << "cannot write " << argv[2] << endl;
+        return 2;
+    }
+
+    long npending = 0;
+    for (long j = 0; j < jobs.size(); j++){
+        npending += !jobs[j].done;
+    }
+    cout << jobs.size() << " jobs, " << jobs.size() - npending << " already done, " << ncores << " cores, "
+         << mem_total << " MB" << endl;
+
+    // a job never gets more cores than there are
+    int threads = (sw.threads < ncores) ? sw.threads : ncores;
+    vector <bool> busy(ncores, false);
+    int free_cores = ncores;
+    double free_mem = mem_total;
+    long nrunning = 0, nfailed = 0, next = 0;
+    map <pid_t, long> running;
+
+    while (npending > 0 || nrunning > 0){
+        for (long j = next; j < jobs.size() && free_cores >= threads; j++){
+            Tjob &job = jobs[j];
+            if (job.done || job.running || (job.mem_mb > free_mem && nrunning > 0)){
+                continue;
+            }
+            job.cores.clear();
+            for (int c = 0; c < ncores && job.cores.size() < threads; c++){
+                if (!busy[c]){
+                    busy[c] = true;
+                    job.cores.push_back(cpus[c]);
+                }
+            }
+            start_job(job, threads);
+            if (!job.running){
+                return 2;
+            }
+            running[job.pid] = j;
+            free_cores -= threads;
+            free_mem -= job.mem_mb;
+            nrunning++;
+            npending--;
+            cout << "started  " << job.command << endl;
+        }
+        // the jobs before next are all done or running
+        while (next < jobs.size() && (jobs[next].done || jobs[next].running)){
+            next++;
+        }
+
+        int wstatus;
+        struct rusage usage;
+        pid_t pid = wait4(-1, &wstatus, 0, &usage);
+        if (pid < 0){
+            perror("wait4");
+            return 2;
+        }
+        if (running.find(pid) == running.end()){
+            continue;
+        }
+        Tjob &job = jobs[running[pid]];
+        running.erase(pid);
+        int status = WIFEXITED(wstatus) ? WEXITSTATUS(wstatus) : 128 + WTERMSIG(wstatus);
+        double wall = now_s() - job.t_start;
+
+        job.running = false;
+        job.done = true;
+        for (int c = 0; c < ncores; c++){
+            for (int k = 0; k < job.cores.size(); k++){
+                if (cpus[c] == job.cores[k]){
+                    busy[c] = false;
+                }
+            }
+        }
+        free_cores += threads;
+        free_mem += job.mem_mb;
+        nrunning--;
+        if (status != 0){
+            nfailed++;
+        }
+
+        // ru_maxrss is in kilobytes on Linux
+        fjournal << "status=" << status << " wall_s=" << wall << " maxrss_kb=" << usage.ru_maxrss << "\t"
+                 << job.command << endl;
+        cout << "finished " << job.command << "   status=" << status << " wall_s=" << wall << endl;
+    }
+
+    fjournal.close();
+    cout << nfailed << " jobs failed" << endl;
+    return (nfailed > 0) ? 1 : 0;
+}
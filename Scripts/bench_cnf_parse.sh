@@ -0,0 +1,40 @@
+#!/bin/bash
+
+# Measures how fast wfacwsat reads a formula, in literals per second, for the
+# DIMACS and binary formats written by Graph_to_CNF_input.out. Each format is
+# read from a file (mapped in memory) and through a pipe, as in
+# run_FMS_KSAT_PD_inner.sh. Through the pipe, the time includes the generation
+# of the formula. It also prints the time needed to generate each file.
+
+N=$1
+alpha=$2
+K=$3
+seed=$4
+path=$5
+
+M=$((alpha * N / 100))
+TIMEFORMAT="generation seconds = %R"
+
+filecnf=$path"bench_K_"$K"_N_"$N"_alpha_"$alpha"_seed_"$seed".cnf"
+filebin=$path"bench_K_"$K"_N_"$N"_alpha_"$alpha"_seed_"$seed".bcnf"
+
+for format in 0 1
+do
+  if [ $format -eq 0 ]; then
+    file=$filecnf
+    name="DIMACS"
+  else
+    file=$filebin
+    name="binary"
+  fi
+
+  echo "# "$name"  N="$N"  M="$M"  K="$K
+  time ./Graph_to_CNF_input.out $N $M $K $seed $format $file
+  echo "from file:"
+  ./wfacwsat -parse -cnf $file
+  echo "from pipe:"
+  ./Graph_to_CNF_input.out $N $M $K $seed $format | ./wfacwsat -parse
+  echo ""
+done
+
+rm -f $filecnf $filebin
@@ -0,0 +1,39 @@
+#!/bin/bash
+
+# Two-stage profile-guided build of all the programs, run from the top directory
+# of the repository. The first stage (preset pgo-generate) builds instrumented
+# programs in build/pgo and runs them on a representative problem. The second
+# one (preset pgo-use) rebuilds them in the same directory with the profiles,
+# because gcc names the profiles after the paths of the object files.
+# The arguments set the size of the training runs, the defaults take a few minutes.
+
+N=${1:-100000}
+alpha=${2:-420}
+K=${3:-3}
+nthr=${4:-4}
+
+M=$((alpha * N / 100))
+Nsmall=$((N / 10))
+Msmall=$((M / 10))
+builddir=build/pgo
+
+cmake --preset pgo-generate || exit 1
+rm -rf $builddir/pgo-data
+cmake --build --preset pgo-generate -j || exit 1
+
+mkdir -p $builddir/training
+cd $builddir/training
+# without GSL the other programs are not built and wfacwsat has no -randomcnf,
+# so there is nothing to train and the second stage is a plain optimized build
+if [ -x ../Graph_to_CNF_input.out ]; then
+  ../wfacwsat -randomcnf $N $M $K 1 -FMS -threads $nthr -restart $nthr -seed 1 -trace $N -cutoff $((N * 20)) -fhist wfacwsat_hist.txt -noise 37 100 > /dev/null
+  ../Graph_to_CNF_input.out $Nsmall $Msmall $K 1 > /dev/null
+  ../CDA_FMS.out $Nsmall $Msmall $K 1 0.37 5 1e-3 $nthr > /dev/null
+  ../CME_FMS.out $Nsmall $Msmall $K 1 0.37 5 1e-3 $nthr > /dev/null
+else
+  echo "GSL not found, the programs are built without training runs"
+fi
+cd - > /dev/null
+
+cmake --preset pgo-use || exit 1
+cmake --build --preset pgo-use -j --clean-first
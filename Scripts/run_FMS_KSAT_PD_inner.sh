@@ -11,15 +11,31 @@ tl=$8
 eta=$9
 path=${10}
 print_every=${11}
+nthreads=${12:-1}
+batch=${13:-0}
 
 M=$((alpha * N / 100))
 
+if [ $batch -eq 1 ]; then
+
+filehist=$path"FMS_KSAT_K_"$K"_eta_"$eta"_N_"$N"_alpha_"$alpha"_ngraphs_"$nsamples"_nhist_"$hist"_tl_"$tl"_idgraph_%d.txt"
+filetries=$path"FMS_tries_K_"$K"_eta_"$eta"_N_"$N"_alpha_"$alpha"_ngraphs_"$nsamples"_nhist_"$hist"_tl_"$tl"_idgraph_%d.txt"
+./wfacwsat -randomcnf $N $M $K 1 -batch $nsamples -FMS -threads $nthreads -restart $hist -seed $seed_fms -trace $iters_save -cutoff $((N * tl)) -print_every $print_every -fhist $filehist -fmin $filetries -noise $eta 100 > $path"out_FMS_K_"$K"_N_"$N"_eta_"$eta"_alpha_"$alpha"_batch_"$nsamples"_tl_"$tl"_dtN_"$iters_save".txt" 2>/dev/null
+echo "sent  N="$N"  M="$M"  eta="$eta" idumgraph=1..."$nsamples
+
+else
+
 for idumgraph in $(seq 1 $nsamples)
 do
 
 filehist=$path"FMS_KSAT_K_"$K"_eta_"$eta"_N_"$N"_alpha_"$alpha"_ngraphs_"$nsamples"_nhist_"$hist"_tl_"$tl"_idgraph_"$idumgraph".txt"
-./Graph_to_CNF_input.out $N $M $K $idumgraph </dev/null 2>/dev/null | ./wfacwsat -FMS -restart $hist -seed $seed_fms -trace $iters_save -cutoff $((N * tl)) -print_every $print_every -fhist $filehist -noise $eta 100 > $path"out_FMS_K_"$K"_N_"$N"_eta_"$eta"_alpha_"$alpha"_idumgraph_"$idumgraph"_tl_"$tl"_dtN_"$iters_save".txt" 2>/dev/null
+filetries=$path"FMS_tries_K_"$K"_eta_"$eta"_N_"$N"_alpha_"$alpha"_ngraphs_"$nsamples"_nhist_"$hist"_tl_"$tl"_idgraph_"$idumgraph".txt"
+./wfacwsat -randomcnf $N $M $K $idumgraph -FMS -threads $nthreads -restart $hist -seed $seed_fms -trace $iters_save -cutoff $((N * tl)) -print_every $print_every -fhist $filehist -fmin $filetries -noise $eta 100 > $path"out_FMS_K_"$K"_N_"$N"_eta_"$eta"_alpha_"$alpha"_idumgraph_"$idumgraph"_tl_"$tl"_dtN_"$iters_save".txt" 2>/dev/null
 echo "sent  N="$N"  M="$M"  eta="$eta" idumgraph="$idumgraph
 
 done
 
+fi
+
+./average_FMS_output.out $N $alpha $K $nsamples $hist $iters_save $tl $eta $path
+
@@ -0,0 +1,24 @@
+#!/bin/bash
+
+# Runs the microbenchmarks of Benchmarks/ and keeps one JSON file per program,
+# named after the current commit, so that the results can be compared across
+# commits (for instance with compare.py from google-benchmark).
+# builddir is the CMake build directory, outdir where the JSON files go, and
+# filter an optional regular expression to run only some benchmarks
+# (e.g. 'der_fms' or '-der_fms/1000000' to leave out the largest graph).
+
+builddir=$1
+outdir=$2
+filter=${3:-.}
+
+commit=$(git rev-parse --short HEAD)
+if [ -n "$(git status --porcelain --untracked-files=no)" ]; then
+  commit=$commit"_dirty"
+fi
+
+mkdir -p "$outdir"
+for program in CDA_FMS CME_FMS CDA_WalkSAT_av_rates
+do
+  "$builddir/bench_$program" --benchmark_filter="$filter" --benchmark_context=commit=$commit \
+    --benchmark_out="$outdir/bench_${program}_${commit}.json" --benchmark_out_format=json
+done
@@ -0,0 +1,105 @@
+#!/bin/bash
+
+# Runs a fixed suite of workloads and checks that their results and their cost did not change.
+# builddir is the CMake build directory, suite one of Scripts/regression_suite*.txt, refdir the
+# directory with the reference outputs that are not in Data/ (they are written there the first time a
+# case runs), outdir where each case runs, baseline (optional) the results file of an earlier run to
+# compare the cost with, nthr the threads given to the programs and slack the relative increase of
+# wall time, peak memory or derivative evaluations that counts as a regression.
+# The results go to outdir/regression_<commit>.txt, which can be the baseline of later runs. The
+# script returns 1 if some case failed.
+
+builddir=$1
+suite=$2
+refdir=$3
+outdir=$4
+baseline=${5:-}
+nthr=${6:-1}
+slack=${7:-0.1}
+
+repo=$(cd "$(dirname "$0")/.." && pwd)
+builddir=$(cd $builddir && pwd)
+mkdir -p $refdir $outdir
+refdir=$(cd $refdir && pwd)
+outdir=$(cd $outdir && pwd)
+
+commit=$(git -C $repo rev-parse --short HEAD)
+if [ -n "$(git -C $repo status --porcelain --untracked-files=no)" ]; then
+  commit=$commit"_dirty"
+fi
+results=$outdir/regression_$commit.txt
+
+# it prints the value of key=value in the file $2
+get_key() {
+  sed -n "s/.*$1=\([^ ]*\).*/\1/p" $2 | head -n 1
+}
+
+echo -e "# name\twall_s\tmaxrss_kb\tnder\tmax_abs_dev\tstatus" > $results
+nfail=0
+while read -r name mode col rtol atol reference output program args
+do
+  if [ -z "$name" ] || [ "${name:0:1}" == "#" ]; then
+    continue
+  fi
+  args=${args//NTHR/$nthr}
+  rundir=$outdir/$name
+  rm -rf $rundir
+  mkdir -p $rundir
+
+  (cd $rundir && $builddir/measure_run.out $rundir/measure.txt $builddir/$program $args \
+     < /dev/null > $rundir/stdout.txt 2>&1)
+  wall=$(get_key wall_s $rundir/measure.txt)
+  rss=$(get_key maxrss_kb $rundir/measure.txt)
+  run_status=$(get_key status $rundir/measure.txt)
+  nder=$(grep "^# profile" $rundir/$output 2> /dev/null | sed -n 's/.*nder=\([^ ]*\).*/\1/p')
+  nder=${nder:--}
+
+  status=""
+  dev="-"
+  if [ "$run_status" != "0" ] || [ ! -f $rundir/$output ]; then
+    status="FAIL_RUN"
+  else
+    if [ "$reference" == "-" ]; then
+      ref=$refdir/$name.txt
+      if [ ! -f $ref ]; then
+        cp $rundir/$output $ref
+        status="NEW_REFERENCE"
+      fi
+    else
+      ref=$repo/$reference
+    fi
+    $builddir/compare_energy.out $mode $ref $rundir/$output $rtol $atol $col > $rundir/compare.txt
+    if [ $? -ne 0 ]; then
+      status="FAIL_ENERGY"
+    fi
+    dev=$(get_key max_abs_dev $rundir/compare.txt)
+  fi
+
+  if [ -n "$baseline" ] && [ "$run_status" == "0" ]; then
+    base=$(awk -v name=$name '$1 == name' $baseline)
+    if [ -n "$base" ]; then
+      perf=$(echo "$base" | awk -v wall=$wall -v rss=$rss -v nder=$nder -v slack=$slack '{
+        s = ""
+        if (wall > $2 * (1 + slack)) s = s ",FAIL_TIME"
+        if (rss > $3 * (1 + slack)) s = s ",FAIL_RSS"
+        if (nder != "-" && $4 != "-" && nder > $4 * (1 + slack)) s = s ",FAIL_NDER"
+        print s
+      }')
+      status=$status$perf
+    fi
+  fi
+
+  status=${status#,}
+  status=${status:-OK}
+  if [[ $status == *FAIL* ]]; then
+    nfail=$((nfail + 1))
+  fi
+  echo -e "$name\t$wall\t$rss\t$nder\t$dev\t$status" >> $results
+  echo -e "$name\twall_s=$wall\tmaxrss_kb=$rss\tnder=$nder\tmax_abs_dev=$dev\t$status"
+done < $suite
+
+echo "results in $results"
+if [ $nfail -gt 0 ]; then
+  echo "$nfail cases failed"
+  exit 1
+fi
@@ -9,18 +9,27 @@
 /* Compilation flags                */
 /************************************/
 
-/* If the constant DYNAMIC is set, then dynamic arrays are used instead of static arrays.
-   This allows very large or very small problems to be handled, without
-   having to adjust the constants MAXATOM and/or MAXCLAUSE.  However, on some
-   architectures the compiled program is about 15% slower, because not
-   as many optimizations can be performed. */
+/* All the arrays are allocated with their exact size once the header
+   "p cnf numatom numclause" has been read, so there is no maximum number
+   of atoms or clauses (the former options MAXATOM, MAXCLAUSE and DYNAMIC
+   are gone). */
 
-/* #define DYNAMIC 1 */
-
-/* Alex Fukunaga watched-literal speedup is enabled if _WATCH is defined.
-   Is is not compatible with the DYNAMIC option!  */
+/* Alex Fukunaga watched-literal speedup is enabled if _WATCH is defined. */
 #define _WATCH
 
+/* If _FASTRNG is defined, each thread draws from its own xoshiro256** generator,
+   integers in [0, n) are sampled with Lemire's multiply-shift method, and FMS
+   accepts a move that breaks `change` clauses with one uniform number compared
+   to eta^change.  Otherwise random() and the original acceptance loop are used. */
+#define _FASTRNG
+
+/* If _GSL is defined, the option -randomcnf generates the formula in memory with
+   the same generator as Graph_to_CNF_input.cpp.  Link with -lgsl -lgslcblas.
+   Compiling with -D_NO_GSL leaves it out. */
+#ifndef _NO_GSL
+#define _GSL
+#endif
+
 
 /********************************************************************/
 /* Please select only one of following flags: UNIX, OSX, ANSI or NT */
@@ -59,6 +68,18 @@
 #endif
 
 
+/* Define THREADLOCAL to be the storage class of the state of a try.
+   Each thread keeps its own copy, so that several tries on the same
+   formula can run at the same time (option -threads).  Only UNIX
+   provides the thread-safe random number generator that is needed. */
+
+#if UNIX
+#define THREADLOCAL __thread
+#else
+#define THREADLOCAL
+#endif
+
+
 /************************************/
 /* Standard includes                */
 /************************************/
@@ -74,6 +95,9 @@
 #if UNIX || OSX
   #include <sys/times.h>
   #include <sys/time.h>
+  #include <sys/stat.h>
+  #include <sys/mman.h>
+  #include <fcntl.h>
   #include <unistd.h>
 #endif
 #if NT
@@ -85,11 +109,95 @@
   #include <sys/time.h>
 #endif
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+#ifdef _GSL
+  #include <gsl/gsl_rng.h>
+#endif
+
 #if ANSI || NT
   #define random() rand()
   #define srandom(seed) srand(seed)
 #endif
 
+#ifdef _FASTRNG
+  #include <stdint.h>
+
+  /* xoshiro256** by Blackman and Vigna, one state per thread */
+  THREADLOCAL uint64_t rng_state[4];
+
+  static inline uint64_t rotl(const uint64_t x, int k)
+  {
+      return (x << k) | (x >> (64 - k));
+  }
+
+  static inline uint64_t next_rng(void)
+  {
+      const uint64_t result = rotl(rng_state[1] * 5, 7) * 9;
+      const uint64_t t = rng_state[1] << 17;
+      rng_state[2] ^= rng_state[0];
+      rng_state[3] ^= rng_state[1];
+      rng_state[1] ^= rng_state[2];
+      rng_state[0] ^= rng_state[3];
+      rng_state[2] ^= t;
+      rng_state[3] = rotl(rng_state[3], 45);
+      return result;
+  }
+
+  /* the state is filled with splitmix64, as recommended by the authors */
+  void seed_rng(uint64_t s)
+  {
+      int i;
+      uint64_t z;
+      for (i = 0; i < 4; i++){
+          z = (s += 0x9e3779b97f4a7c15ULL);
+          z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+          z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+          rng_state[i] = z ^ (z >> 31);
+      }
+  }
+
+  /* uniform integer in [0, n), without modulo bias (Lemire 2019) */
+  static inline uint32_t rand_below(uint32_t n)
+  {
+      uint64_t m = (next_rng() >> 32) * (uint64_t) n;
+      uint32_t l = (uint32_t) m;
+      uint32_t t;
+      if (l < n){
+          t = -n % n;
+          while (l < t){
+              m = (next_rng() >> 32) * (uint64_t) n;
+              l = (uint32_t) m;
+          }
+      }
+      return (uint32_t) (m >> 32);
+  }
+
+  /* uniform double in [0, 1) */
+  static inline double rand_uniform(void)
+  {
+      return (next_rng() >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  #define RANDBELOW(n) ((int) rand_below((uint32_t) (n)))
+#else
+  #if UNIX
+    /* each thread draws from its own stream, with the same generator as random() */
+    THREADLOCAL struct random_data rand_data;
+    THREADLOCAL char rand_statebuf[128];
+    long thread_random(void)
+    {
+        int32_t result;
+        random_r(&rand_data, &result);
+        return result;
+    }
+    #define random() thread_random()
+  #endif
+  #define RANDBELOW(n) (random()%(n))
+#endif
+
 /* No longer using constant CLK_TCK - it is deprecated! */
 /* Instead: */
 long ticks_per_second;
@@ -99,14 +207,7 @@ long ticks_per_second;
 /* Constant parameters              */
 /************************************/
 
-#define MAXATOM 1000100      /* maximum possible number of atoms */
-
-#ifdef DYNAMIC
-  #define STOREBLOCK 20000000   /* size of block to malloc each time */
-#else
-  #define STOREBLOCK 20000000   /* size of block to malloc each time */
-  #define MAXCLAUSE 11000000 /* maximum possible number of clauses */
-#endif
+#define STOREBLOCK 20000000   /* maximum growth of the literal store while reading */
 
 #define TRUE 1
 #define FALSE 0
@@ -124,10 +225,10 @@ RNOVELTY_PLUS, FMS, ASAT, CHAIN };
 #define INIT_PARTIAL 1
 #define HISTMAX 101     /* length of histogram of tail */
 
-#define Var(CLAUSE, POSITION) (ABS(clause[CLAUSE][POSITION]))
+#define Var(CLAUSE, POSITION) (ABS(CLLITS(CLAUSE)[POSITION]))
 
-static int scratch;
-#define ABS(x) ((scratch=(x))>0?(scratch):(-scratch))
+/* abs() evaluates its argument once, without the shared scratch variable */
+#define ABS(x) abs(x)
 
 #define BIG 100000000
 
@@ -137,57 +238,111 @@ static int scratch;
 
 /* Atoms start at 1 */
 /* Not a is recorded as -1 * a */
-/* One dimensional arrays are statically allocated. */
-/* Two dimensional arrays are dynamically allocated in */
-/* the second dimension only.  */
+/* Arrays are allocated by initprob() with the sizes in the header. */
+/* The literals of all the clauses are stored in one block, and the */
+/* occurrences of all the literals in another one (CSR layout). */
+/* The formula is shared by all the threads.  The state of a try */
+/* is THREADLOCAL and allocated by init_thread() in each thread. */
 
 int numatom;
 int numclause;
 int numliterals;
 
-#ifdef DYNAMIC
 int ** clause;          /* clauses to be satisfied */
                 /* indexed as clause[clause_num][literal_num] */
 int * size;         /* length of each clause */
-int * false;            /* clauses which are false */
-int * lowfalse;
-int * wherefalse;       /* where each clause is listed in false */
-int * numtruelit;       /* number of true literals in each clause */
+
+THREADLOCAL int * false;        /* clauses which are false */
+THREADLOCAL int * lowfalse;
+
+/* Each thread keeps one record of clstride ints per clause, so that */
+/* flipatom() finds everything it needs about a clause in one cache line: */
+/*   [numtruelit, watch1, watch2, wherefalse, size, literals...] */
+/* The records are padded to the longest clause. */
+THREADLOCAL int * clrec;
+int clstride;
+
+#define CLREC(c) (clrec + (long) (c) * clstride)
+#define R_NUMTRUELIT(r) ((r)[0])   /* number of true literals in the clause */
+#define R_WATCH1(r) ((r)[1])
+#define R_WATCH2(r) ((r)[2])
+#define R_WHEREFALSE(r) ((r)[3])   /* where the clause is listed in false */
+#define R_SIZE(r) ((r)[4])
+#define R_LITS(r) ((r) + 5)
+#define NUMTRUELIT(c) R_NUMTRUELIT(CLREC(c))
+#define WATCH1(c) R_WATCH1(CLREC(c))
+#define WATCH2(c) R_WATCH2(CLREC(c))
+#define WHEREFALSE(c) R_WHEREFALSE(CLREC(c))
+#define CLSIZE(c) R_SIZE(CLREC(c))
+#define CLLITS(c) R_LITS(CLREC(c))
+
+int * occ_start;        /* the clauses where literal+numatom = l occurs are */
+int * occ_list;         /* occ_list[occ_start[l]] ... occ_list[occ_start[l+1]-1] */
+
+#ifdef __GNUC__
+#define PREFETCH(ptr) __builtin_prefetch(ptr)
 #else
-int * clause[MAXCLAUSE];    /* clauses to be satisfied */
-                /* indexed as clause[clause_num][literal_num] */
-int size[MAXCLAUSE];        /* length of each clause */
-int false[MAXCLAUSE];       /* clauses which are false */
-int lowfalse[MAXCLAUSE];
-int wherefalse[MAXCLAUSE];  /* where each clause is listed in false */
-int numtruelit[MAXCLAUSE];  /* number of true literals in each clause */
+#define PREFETCH(ptr)
 #endif
 
-int *occurence[2*MAXATOM+1];    /* where each literal occurs */
-                /* indexed as occurence[literal+MAXATOM][occurence_num] */
+#define NUMOCCURENCE(l) (occ_start[(l)+1] - occ_start[l])
+#define OCCURENCE(l) (occ_list + occ_start[l])
 
-int numoccurence[2*MAXATOM+1];  /* number of times each literal occurs */
 
+THREADLOCAL int * atom;         /* value of each atom */ 
+THREADLOCAL int * lowatom;
+int * solution;
 
-int atom[MAXATOM+1];        /* value of each atom */ 
-int lowatom[MAXATOM+1];
-int solution[MAXATOM+1];
+THREADLOCAL int * changed;      /* step at which atom was last flipped */
 
-int changed[MAXATOM+1];     /* step at which atom was last flipped */
+/* varcount[2*var] is the number of clauses that become unsat if var is flipped (breakcount) */
+/* and varcount[2*var+1] the number of clauses that become sat (makecount), side by side */
+THREADLOCAL int * varcount;
+#define BREAKCOUNT(v) (varcount[2*(v)])
+#define MAKECOUNT(v) (varcount[2*(v)+1])
 
-int breakcount[MAXATOM+1];  /* number of clauses that become unsat if var if flipped */
-int makecount[MAXATOM+1];   /* number of clauses that become sat if var if flipped */
+THREADLOCAL int numfalse;       /* number of false clauses */
 
-int numfalse;           /* number of false clauses */
+BIGINT * history;               /* sum over the finished tries, 64 bits to avoid overflows */
+int numpoints = 1;              /* length of history */
+THREADLOCAL int * history_try;  /* history of the current try */
+THREADLOCAL int history_point;  /* next point of history_try */
+THREADLOCAL BIGINT trace_countdown; /* flips left until the next point */
 
-#define MAXPOINTS 1000100
-int history[MAXPOINTS];
+char filemin[1024] = { 0 };     /* -fmin: lowest and final number of false clauses of each try */
+FILE * fmin_fp;
+THREADLOCAL BIGINT lowflip;     /* flip at which lowbad was reached */
 
 int print_every = 50;
 
+double * history2;              /* sum over the finished tries of the squares, for -stderr */
+double target_stderr = 0;       /* -stderr: stop when the error of every point is below it */
+int min_stderr_tries = 10;      /* and at least this number of tries are finished */
+int stop_flag = FALSE;
+
+char filecheck[1024] = { 0 };   /* -checkpoint: state to resume the run from */
+long fmin_offset = 0;           /* length of the -fmin file when the checkpoint was written */
+
+/* a try that ends before the tries with lower numbers waits in pending, so that the tries */
+/* are added to the history, to -fmin and to the tests to stop in the order of their numbers */
+typedef struct {
+  int numtry;
+  long int lowbad;
+  BIGINT lowflip;
+  int numfalse;
+  BIGINT numflip;
+  int npoints;          /* points of history that were written */
+  int * history;
+} finished_try;
+finished_try * pending = NULL;
+int npending = 0;
+int pendingcap = 0;
+
+int nthreads = 1;       /* number of tries run at the same time */
+
+double * eta_pow;       /* eta_pow[c] = (numerator/denominator)^c, for FMS */
+
 #ifdef _WATCH 
-int watch1[MAXCLAUSE];
-int watch2[MAXCLAUSE];
 #include <assert.h>
 #endif
 
@@ -207,8 +362,8 @@ int tabu_length;        /* length of tabu list */
 int wp_numerator = NOVALUE; /* walk probability numerator/denominator */
 int wp_denominator = 100;       
 
-BIGINT numflip;     /* number of changes so far */
-BIGINT numnullflip;     /*  number of times a clause was picked, but no  */
+THREADLOCAL BIGINT numflip;     /* number of changes so far */
+THREADLOCAL BIGINT numnullflip; /*  number of times a clause was picked, but no  */
                 /*  variable from it was flipped  */
 int numrun = 10;
 BIGINT cutoff = 100000;
@@ -224,7 +379,7 @@ int whiteflag = FALSE;      /* set to true by the option -whitening */
 
 /* Histogram of tail */
 
-long int tailhist[HISTMAX]; /* histogram of num unsat in tail of run */
+THREADLOCAL long int tailhist[HISTMAX]; /* histogram of num unsat in tail of run */
 long histtotal;
 int tail = 3;
 int tail_start_flip;
@@ -247,6 +402,36 @@ char filehist[1024] = { 0 };
 char initfile[100] = { 0 };
 int initoptions = FALSE;
 
+/* Input of the formula */
+/* The formula is read from the file given with -cnf, or from stdin.  Files are */
+/* mapped in memory, stdin is read into a buffer.  Both DIMACS and the binary */
+/* format written by Graph_to_CNF_input.cpp are accepted.  The binary format is */
+/*   "BCNF" int32 numatom, int32 numclause, int64 numliterals, */
+/*   int32 size[numclause], int32 literals[numliterals] */
+/* in the byte order of the machine, without the 0 that ends each clause. */
+
+#define BCNF_MAGIC "BCNF"
+#define BCNF_HEADER 20
+
+char cnffile[1024] = { 0 };
+int parseonly = FALSE;      /* set by -parse: print the parse throughput and exit */
+
+/* Random formula generated in memory (-randomcnf N M K seed) */
+int genflag = FALSE;
+long gen_N;
+long gen_M;
+int gen_K;
+unsigned long gen_seed;
+
+/* Batch of random formulas (-batch NINST): formula i is generated with the seed */
+/* gen_seed + i and solved by all the threads before the next one. The %d in the */
+/* names of the output files is replaced by the seed of the formula */
+int nbatch = 1;
+char patternhist[1024] = { 0 };
+char patternmin[1024] = { 0 };
+char patterncheck[1024] = { 0 };
+char patternout[1024] = { 0 };
+
 /* Randomization */
 
 unsigned int seed;  /* Sometimes defined as an unsigned long int */
@@ -263,7 +448,7 @@ unsigned int seed;  /* Sometimes defined as an unsigned long int */
 
 double expertime;
 BIGINT flips_this_solution;
-long int lowbad;        /* lowest number of bad clauses during try */
+THREADLOCAL long int lowbad;    /* lowest number of bad clauses during try */
 BIGINT totalflip = 0;       /* total number of flips in all tries so far */
 BIGINT totalsuccessflip = 0;    /* total number of flips in all tries which succeeded so far */
 int numsuccesstry = 0;      /* total found solutions */
@@ -287,12 +472,12 @@ double std_dev_r;
 double std_error_mean_r;
 
 double avgfalse;
-double sumfalse;
-double sumfalse_squared;
+THREADLOCAL double sumfalse;
+THREADLOCAL double sumfalse_squared;
 double second_moment_avgfalse, variance_avgfalse, std_dev_avgfalse, ratio_avgfalse;
 double std_dev_avgfalse;
 double f;
-double sample_size;
+THREADLOCAL double sample_size;
 
 double sum_avgfalse = 0.0;
 double sum_std_dev_avgfalse = 0.0;
@@ -321,8 +506,8 @@ char hamming_target_file[512] = { 0 };
 char hamming_data_file[512] = { 0 };
 int hamming_sample_freq;
 int hamming_flag = FALSE;
-int hamming_distance;
-int hamming_target[MAXATOM+1];
+THREADLOCAL int hamming_distance;
+int * hamming_target;
 void read_hamming_file(char initfile[]);
 void open_hamming_data(char initfile[]);
 int calc_hamming_dist(int atom[], int hamming_target[], int numatom);
@@ -332,7 +517,7 @@ FILE * hamming_fp;
 int samplefreq = 1;
 
 /* Current variable in the chain (Chain-heuristic) */
-int varChain;
+THREADLOCAL int varChain;
 
 /************************************/
 /* Forward declarations             */
@@ -366,6 +551,17 @@ void scanone(int argc, char *argv[], int i, int *varptr);
 void scanonell(int argc, char *argv[], int i, BIGINT *varptr);
 void init(char initfile[], int initoptions);
 void initprob(void); 
+char * read_input(char * filename, size_t * length);
+void parse_dimacs(char * buf, size_t length);
+void parse_binary(char * buf, size_t length);
+void alloc_formula(void);
+void init_occurence(void);
+void generate_formula(long N, long M, int K, unsigned long seed);
+double wall_seconds(void);
+void init_thread(int tid);
+void seed_try(int thistry);
+void instance_name(char * name, char * pattern, unsigned long id);
+void init_eta_pow(void);
 void flipatom(int toflip);
 
 void print_false_clauses(long int lowbad);
@@ -386,7 +582,14 @@ void update_statistics_start_try(void);
 void print_statistics_start_flip(void);
 void update_history(void);
 void init_history(void);
-void print_history(char *filename, int max_numflip);
+void reduce_history(int * h, int npoints);
+void commit_try(finished_try * t, BIGINT * max_numflip);
+void finish_try(int thistry, BIGINT * max_numflip);
+void drop_pending(void);
+void print_history(char *filename, BIGINT max_numflip);
+int stderr_reached(BIGINT max_numflip);
+void save_checkpoint(BIGINT max_numflip);
+int load_checkpoint(BIGINT *max_numflip);
 void update_and_print_statistics_end_try(void);
 void update_statistics_end_flip(void);
 void print_statistics_final(void);
@@ -414,26 +617,98 @@ int main(int argc,char *argv[])
     seed = (unsigned int)(time());
 #endif
     parse_parameters(argc, argv);
-    srandom(seed);
     // print_parameters(argc, argv);
-    initprob();
-    initialize_statistics();
-    init_history();
     // print_statistics_header();
     signal(SIGINT, handle_interrupt);
     abort_flag = FALSE;
+
+    BIGINT max_numflip = 0;
+    int numstarted = 0;   /* tries already handed to a thread */
+    int resumed = FALSE;
+    int batch_stop = FALSE;
+    unsigned long first_seed = gen_seed;
+
+    if (nbatch > 1){
+      strcpy(patternhist, filehist);
+      strcpy(patternmin, filemin);
+      strcpy(patterncheck, filecheck);
+      strcpy(patternout, outfile);
+    }
+
+    /* the threads are kept for all the formulas of the batch, and their */
+    /* buffers are only reallocated when a formula is larger than the previous ones */
+#pragma omp parallel num_threads(nthreads) private(var)
+    {
+    int inst;
+    int thistry;
+    BIGINT thiscutoff = cutoff;
+#ifdef _OPENMP
+    int tid = omp_get_thread_num();
+#else
+    int tid = 0;
+#endif
+
+    for (inst = 0; inst < nbatch && ! batch_stop; inst++) {
+#pragma omp single
+    {
+    if (nbatch > 1){
+      gen_seed = first_seed + inst;
+      instance_name(filehist, patternhist, gen_seed);
+      instance_name(filemin, patternmin, gen_seed);
+      instance_name(filecheck, patterncheck, gen_seed);
+      instance_name(outfile, patternout, gen_seed);
+      printf("\nformula seed = %lu\n", gen_seed);
+    }
+    initprob();
+    init_eta_pow();
+    initialize_statistics();
+    init_history();
+
+    max_numflip = 0;
+    numtry = 0;
+    stop_flag = FALSE;
+    resumed = FALSE;
+    if (filecheck[0])
+      resumed = load_checkpoint(&max_numflip);
+    numstarted = numtry;
+
+    if (filemin[0]){
+      /* the lines of the tries finished after the checkpoint are dropped, those tries run again */
+      if (resumed && truncate(filemin, fmin_offset) == 0)
+        fmin_fp = fopen(filemin, "a");
+      else
+        fmin_fp = fopen(filemin, "w");
+      if (fmin_fp == NULL){
+        fprintf(stderr, "Cannot open %s for output\n", filemin);
+        exit(-1);
+      }
+      if (ftell(fmin_fp) == 0)
+        fprintf(fmin_fp, "# try\tmin_numfalse\tflip_of_min\tfinal_numfalse\tnumflip\n");
+    }
     (void) elapsed_seconds();
+    }
 
-    int max_numflip = 0;
-    while (! abort_flag && numsuccesstry < numsol && numtry < numrun) {
-    numtry++;
+    /* each thread runs whole tries on the shared formula. Their histories are */
+    /* added to the common one in the order of the tries (see finish_try) */
+    init_thread(tid);
+    while (TRUE) {
+#pragma omp critical (tries)
+    {
+    if (! abort_flag && ! stop_flag && numsuccesstry < numsol && numstarted < numrun)
+      thistry = ++numstarted;
+    else
+      thistry = 0;
+    }
+    if (thistry == 0) break;
+
+    seed_try(thistry);
     init(initfile, initoptions);
     update_statistics_start_try();
     numflip = 0;
       
-    if (superlinear) cutoff = base_cutoff * super(numtry);
+    if (superlinear) thiscutoff = base_cutoff * super(thistry);
 
-    while((numfalse > target) && (numflip < cutoff)) {
+    while((numfalse > target) && (numflip < thiscutoff)) {
         //print_statistics_start_flip();
         update_history();
         numflip++;
@@ -442,17 +717,27 @@ int main(int argc,char *argv[])
         update_statistics_end_flip();
     }
 
-    if (numflip > max_numflip) max_numflip = numflip;
+#pragma omp critical (tries)
+    finish_try(thistry, &max_numflip);
     //update_and_print_statistics_end_try();
-      if (numtry % print_every == 0){
-        print_history(filehist, max_numflip);
-      }
     }
 
+#pragma omp barrier
+#pragma omp single
+    {
+    drop_pending();
     print_history(filehist, max_numflip);
+    if (filemin[0]) fflush(fmin_fp);
+    if (filecheck[0]) save_checkpoint(max_numflip);
+    if (filemin[0]) fclose(fmin_fp);
 
     expertime = elapsed_seconds();
     print_statistics_final();
+    batch_stop = abort_flag;
+    }
+    }
+    }
+
     return status_flag;
 }
 
@@ -577,10 +862,47 @@ void parse_parameters(int argc,char *argv[])
         scanone(argc,argv,++i,&print_every);
     else if (strcmp(argv[i],"-fhist") == 0)
         strcpy(filehist, argv[++i]);
+    else if (strcmp(argv[i],"-fmin") == 0 && i<argc-1)
+        strcpy(filemin, argv[++i]);
+    else if (strcmp(argv[i],"-threads") == 0)
+        scanone(argc,argv,++i,&nthreads);
+    else if (strcmp(argv[i],"-batch") == 0)
+        scanone(argc,argv,++i,&nbatch);
+    else if (strcmp(argv[i],"-checkpoint") == 0 && i<argc-1)
+        strcpy(filecheck, argv[++i]);
+    else if (strcmp(argv[i],"-stderr") == 0){
+        if (i>=argc-1 || sscanf(argv[++i], "%lf", &target_stderr) != 1){
+        fprintf(stderr, "Bad argument for -stderr\n");
+        exit(-1);
+        }
+        if (i<argc-1 && sscanf(argv[i+1],"%i",&temp)==1){
+        min_stderr_tries = temp;
+        i++;
+        }
+    }
+    else if (strcmp(argv[i],"-cnf") == 0 && i<argc-1)
+        strcpy(cnffile, argv[++i]);
+    else if (strcmp(argv[i],"-parse") == 0)
+        parseonly = TRUE;
+    else if (strcmp(argv[i],"-randomcnf") == 0 && i < argc-4){
+        if (sscanf(argv[++i], "%li", &gen_N) != 1 || sscanf(argv[++i], "%li", &gen_M) != 1 ||
+            sscanf(argv[++i], "%i", &gen_K) != 1 || sscanf(argv[++i], "%lu", &gen_seed) != 1 ||
+            gen_K < 1 || gen_K > gen_N || gen_K > MAXLENGTH || gen_M < 1){
+        fprintf(stderr, "Bad arguments for -randomcnf\n");
+        exit(-1);
+        }
+        genflag = TRUE;
+    }
     else 
     {
         fprintf(stderr, "General parameters:\n");
         fprintf(stderr, "  -seed N -cutoff N -restart N\n");
+        fprintf(stderr, "  -threads N = run N tries at the same time (try t uses a generator seeded with seed and t)\n");
+        fprintf(stderr, "  -cnf FILE = read the formula (DIMACS or binary) from FILE instead of stdin\n");
+        fprintf(stderr, "  -parse = read the formula, print the parse throughput and exit\n");
+        fprintf(stderr, "  -randomcnf N M K SEED = generate the formula as Graph_to_CNF_input.out N M K SEED\n");
+        fprintf(stderr, "  -batch N = solve the formulas of -randomcnf with SEED, SEED+1, ..., SEED+N-1,\n");
+        fprintf(stderr, "     the %%d in the names of the output files is replaced by the seed of the formula\n");
         fprintf(stderr, "  -numsol N = stop after finding N solutions\n");
         fprintf(stderr, "  -super = use the Luby series for the cutoff values\n");
         fprintf(stderr, "  -init FILE = set vars not included in FILE to false\n");
@@ -601,6 +923,10 @@ void parse_parameters(int argc,char *argv[])
         fprintf(stderr, "  -low = print lowest assignment each try\n");
         fprintf(stderr, "  -bad = print unsat clauses each try\n");
         fprintf(stderr, "  -hist = print histogram of tail\n");
+        fprintf(stderr, "  -fmin FILE = print the lowest and final # unsat of each try to FILE\n");
+        fprintf(stderr, "  -checkpoint FILE = save the run to FILE every print_every tries, resume from it if it exists\n");
+        fprintf(stderr, "  -stderr X or -stderr X M (default M = 10) = stop when the standard error of the\n");
+        fprintf(stderr, "     averaged history is below X at every point, after at least M tries\n");
         fprintf(stderr, "  -tail N = assume tail begins at nvars*N\n");
         fprintf(stderr, "  -sample N = sample noise level every N flips\n");
         fprintf(stderr, "  -hamming TARGET_FILE DATA_FILE SAMPLE_FREQUENCY\n");
@@ -609,6 +935,26 @@ void parse_parameters(int argc,char *argv[])
     }
     base_cutoff = cutoff;
     if (numsol==NOVALUE || numsol>numrun) numsol = numrun;
+    if (nbatch < 1) nbatch = 1;
+    if (nbatch > 1){
+      if (! genflag || parseonly || hamming_flag){
+        fprintf(stderr, "-batch needs -randomcnf, and cannot be used with -parse or -hamming\n");
+        exit(-1);
+      }
+      /* otherwise every formula would overwrite the files of the previous one */
+      if (! strstr(filehist, "%d") || (filemin[0] && ! strstr(filemin, "%d")) ||
+          (filecheck[0] && ! strstr(filecheck, "%d")) || (outfile[0] && ! strstr(outfile, "%d"))){
+        fprintf(stderr, "With -batch, the names of the output files must contain %%d\n");
+        exit(-1);
+      }
+    }
+#if UNIX
+    if (nthreads < 1) nthreads = 1;
+    /* the hamming data file is written flip by flip */
+    if (hamming_flag) nthreads = 1;
+#else
+    nthreads = 1;
+#endif
     if (numerator==NOVALUE){
     switch(heuristic) {
     case BEST:
@@ -702,6 +1048,9 @@ void update_statistics_start_try(void)
     int i;
 
     lowbad = numfalse;
+    lowflip = 0;
+    history_point = 0;
+    trace_countdown = printtrace ? 0 : LLONG_MAX;
 
     sample_size = 0;
     sumfalse = 0.0;
@@ -728,36 +1077,244 @@ void print_statistics_start_flip(void)
 }
 
 
+/* the history has one point every printtrace flips up to the longest cutoff */
 void init_history(void)
 {
+    BIGINT maxcutoff;
     int it;
-    for (it=0; it < cutoff/printtrace; it++){
-      history[it] = 0;
+
+    maxcutoff = cutoff;
+    if (superlinear){
+      for (it=1; it <= numrun; it++)
+        if (base_cutoff * super(it) > maxcutoff) maxcutoff = base_cutoff * super(it);
+    }
+    numpoints = printtrace ? maxcutoff/printtrace + 1 : 1;
+    if (history == NULL){
+      history = (BIGINT *) calloc(numpoints, sizeof(BIGINT));
+      history2 = (double *) calloc(numpoints, sizeof(double));
+    }
+    else{
+      /* next formula of a batch, numpoints does not change */
+      memset(history, 0, sizeof(BIGINT)*numpoints);
+      memset(history2, 0, sizeof(double)*numpoints);
+    }
+    if (history == NULL || history2 == NULL){
+      fprintf(stderr, "ERROR - not enough memory for the history\n");
+      exit(-1);
     }
 }
 
 
+/* records numfalse every printtrace flips, counting down instead of taking numflip % printtrace */
 void update_history(void)
 {
-    if (printtrace && (numflip % printtrace == 0)){
-      history[numflip/printtrace] += numfalse;
+    if (trace_countdown-- == 0){
+      history_try[history_point++] += numfalse;
+      trace_countdown = printtrace - 1;
+    }
+}
+
+
+/* adds the first npoints of the history h of a finished try to the common one, and clears them */
+/* it must be called by one thread at a time */
+void reduce_history(int * h, int npoints)
+{
+    int it;
+    for (it=0; it < npoints; it++){
+      history[it] += h[it];
+      history2[it] += (double) h[it] * h[it];
+      h[it] = 0;
     }
 }
 
 
-void print_history(char * filename, int max_numflip)
+/* adds the finished try t to the common results, and stops the run if the error is small */
+/* enough. It must be called by one thread at a time, with the tries in order */
+void commit_try(finished_try * t, BIGINT * max_numflip)
+{
+    numtry++;
+    if (t->numflip > *max_numflip) *max_numflip = t->numflip;
+    reduce_history(t->history, t->npoints);
+    if (filemin[0])
+      fprintf(fmin_fp, "%i\t%li\t%lld\t%i\t%lld\n", t->numtry, t->lowbad, t->lowflip, t->numfalse, t->numflip);
+    if (target_stderr > 0 && numtry >= min_stderr_tries && stderr_reached(*max_numflip)){
+      stop_flag = TRUE;
+      printf("standard error below %g after %d tries\n", target_stderr, numtry);
+    }
+    if (numtry % print_every == 0){
+      print_history(filehist, *max_numflip);
+      if (filemin[0]) fflush(fmin_fp);
+      if (filecheck[0]) save_checkpoint(*max_numflip);
+    }
+}
+
+
+/* called by the thread that ran try thistry when it ends. The try is added to the */
+/* results if all the tries before it are, and then the pending tries that follow it. */
+/* Otherwise its history is moved to pending and the thread gets a new array. After a */
+/* stop the tries are dropped, so the results do not depend on the number of threads. */
+/* It must be called by one thread at a time */
+void finish_try(int thistry, BIGINT * max_numflip)
+{
+    finished_try done;
+    int i;
+
+    if (stop_flag){
+      memset(history_try, 0, sizeof(int) * history_point);
+      return;
+    }
+    done.numtry = thistry;
+    done.lowbad = lowbad;
+    done.lowflip = lowflip;
+    done.numfalse = numfalse;
+    done.numflip = numflip;
+    done.npoints = history_point;
+    done.history = history_try;
+    if (thistry != numtry + 1){
+      if (npending == pendingcap){
+        pendingcap = pendingcap ? 2 * pendingcap : 16;
+        pending = (finished_try *) realloc(pending, sizeof(finished_try) * pendingcap);
+      }
+      history_try = (int *) calloc(numpoints, sizeof(int));
+      if (pending == NULL || history_try == NULL){
+        fprintf(stderr, "ERROR - not enough memory for the finished tries\n");
+        exit(-1);
+      }
+      pending[npending++] = done;
+      return;
+    }
+    commit_try(&done, max_numflip);
+    i = 0;
+    while (i < npending && ! stop_flag){
+      if (pending[i].numtry == numtry + 1){
+        commit_try(&pending[i], max_numflip);
+        free(pending[i].history);
+        pending[i] = pending[--npending];
+        i = 0;
+      }
+      else
+        i++;
+    }
+}
+
+
+/* frees the tries that ended after a stop of the run and were not added to the results */
+void drop_pending(void)
+{
+    int i;
+    for (i = 0; i < npending; i++)
+      free(pending[i].history);
+    npending = 0;
+}
+
+
+void print_history(char * filename, BIGINT max_numflip)
 {
   FILE * fhist;
   fhist = fopen(filename, "w");
   fprintf(fhist, "#nhist\t%d\n", numtry);
   int it;
-  for (it=0; it < max_numflip/printtrace + 1; it++){
-    fprintf(fhist, "%li\t%lf\n", it * printtrace, (double) history[it] / numtry);
+  int npoints = printtrace ? max_numflip/printtrace + 1 : 1;
+  for (it=0; it < npoints && it < numpoints; it++){
+    fprintf(fhist, "%lld\t%lf\n", it * printtrace, (double) history[it] / numtry);
   }
   fclose(fhist);
 }
 
 
+/* TRUE if the standard error of the average is below target_stderr at every point */
+/* up to the longest try. The points after the end of a try count as zero, as in the history */
+int stderr_reached(BIGINT max_numflip)
+{
+  int it;
+  int npoints = printtrace ? max_numflip/printtrace + 1 : 1;
+  double mean, var;
+  if (numtry < 2) return FALSE;
+  for (it=0; it < npoints && it < numpoints; it++){
+    mean = (double) history[it] / numtry;
+    var = (history2[it] - numtry * mean * mean) / (numtry - 1);
+    if (var > 0 && var / numtry >= target_stderr * target_stderr) return FALSE;
+  }
+  return TRUE;
+}
+
+
+/* writes the number of finished tries and their history to filecheck. Since the generator */
+/* of a try only depends on its number, the tries after them run again from the start. */
+/* It is written to filecheck.tmp and then renamed, so a run killed meanwhile leaves the */
+/* previous checkpoint in place. It must be called by one thread at a time */
+void save_checkpoint(BIGINT max_numflip)
+{
+  FILE * fcheck;
+  char filetmp[1100];
+  int ok;
+  sprintf(filetmp, "%s.tmp", filecheck);
+  if ((fcheck = fopen(filetmp, "wb")) == NULL){
+    fprintf(stderr, "Cannot open %s for output\n", filetmp);
+    return;
+  }
+  fmin_offset = filemin[0] ? ftell(fmin_fp) : 0;
+  ok = fwrite("WFC2", 1, 4, fcheck) == 4;
+  ok = ok && fwrite(&numatom, sizeof(int), 1, fcheck) == 1;
+  ok = ok && fwrite(&numclause, sizeof(int), 1, fcheck) == 1;
+  ok = ok && fwrite(&numpoints, sizeof(int), 1, fcheck) == 1;
+  ok = ok && fwrite(&printtrace, sizeof(BIGINT), 1, fcheck) == 1;
+  ok = ok && fwrite(&seed, sizeof(unsigned int), 1, fcheck) == 1;
+  ok = ok && fwrite(&numtry, sizeof(int), 1, fcheck) == 1;
+  ok = ok && fwrite(&numsuccesstry, sizeof(int), 1, fcheck) == 1;
+  ok = ok && fwrite(&max_numflip, sizeof(BIGINT), 1, fcheck) == 1;
+  ok = ok && fwrite(&fmin_offset, sizeof(long), 1, fcheck) == 1;
+  ok = ok && fwrite(history, sizeof(BIGINT), numpoints, fcheck) == numpoints;
+  ok = ok && fwrite(history2, sizeof(double), numpoints, fcheck) == numpoints;
+  ok = (fclose(fcheck) == 0) && ok;
+  if (! ok || rename(filetmp, filecheck) != 0){
+    fprintf(stderr, "Cannot write the checkpoint %s\n", filecheck);
+    remove(filetmp);
+  }
+}
+
+
+/* if filecheck exists, restores the state written by save_checkpoint(). The tries that were */
+/* running when it was written start again, so the result is the same as without interruption, */
+/* with any number of threads */
+int load_checkpoint(BIGINT * max_numflip)
+{
+  FILE * fcheck;
+  char magic[4];
+  int c_numatom, c_numclause, c_numpoints;
+  BIGINT c_printtrace;
+  unsigned int c_seed;
+  int ok;
+
+  if ((fcheck = fopen(filecheck, "rb")) == NULL) return FALSE;
+
+  ok = fread(magic, 1, 4, fcheck) == 4 && memcmp(magic, "WFC2", 4) == 0;
+  ok = ok && fread(&c_numatom, sizeof(int), 1, fcheck) == 1;
+  ok = ok && fread(&c_numclause, sizeof(int), 1, fcheck) == 1;
+  ok = ok && fread(&c_numpoints, sizeof(int), 1, fcheck) == 1;
+  ok = ok && fread(&c_printtrace, sizeof(BIGINT), 1, fcheck) == 1;
+  ok = ok && fread(&c_seed, sizeof(unsigned int), 1, fcheck) == 1;
+  if (! ok || c_numatom != numatom || c_numclause != numclause || c_numpoints != numpoints ||
+      c_printtrace != printtrace || c_seed != seed){
+    fprintf(stderr, "The checkpoint %s does not belong to this run\n", filecheck);
+    exit(-1);
+  }
+  ok = fread(&numtry, sizeof(int), 1, fcheck) == 1;
+  ok = ok && fread(&numsuccesstry, sizeof(int), 1, fcheck) == 1;
+  ok = ok && fread(max_numflip, sizeof(BIGINT), 1, fcheck) == 1;
+  ok = ok && fread(&fmin_offset, sizeof(long), 1, fcheck) == 1;
+  ok = ok && fread(history, sizeof(BIGINT), numpoints, fcheck) == numpoints;
+  ok = ok && fread(history2, sizeof(double), numpoints, fcheck) == numpoints;
+  fclose(fcheck);
+  if (! ok){
+    fprintf(stderr, "The checkpoint %s is truncated\n", filecheck);
+    exit(-1);
+  }
+  printf("resuming from %s after %d tries\n", filecheck, numtry);
+  return TRUE;
+}
+
+
 void update_and_print_statistics_end_try(void)
 {
     int i;
@@ -868,6 +1425,7 @@ void update_statistics_end_flip(void)
 {
     if (numfalse < lowbad){
     lowbad = numfalse;
+    lowflip = numflip;
     if (printfalse) save_false_clauses(lowbad);
     if (printlow) save_low_assign();
     }
@@ -1090,14 +1648,14 @@ void init(char initfile[], int initoptions)
     int lit;
 
     for(i = 0;i < numclause;i++)
-      numtruelit[i] = 0;
+      NUMTRUELIT(i) = 0;
     numfalse = 0;
 
     for(i = 1;i < numatom+1;i++)
       {
       changed[i] = -BIG;
-      breakcount[i] = 0;
-      makecount[i] = 0;
+      BREAKCOUNT(i) = 0;
+      MAKECOUNT(i) = 0;
       }
 
     if (initfile[0] && initoptions!=INIT_PARTIAL){
@@ -1106,7 +1664,7 @@ void init(char initfile[], int initoptions)
     }
     else {
     for(i = 1;i < numatom+1;i++)
-      atom[i] = random()%2;
+      atom[i] = RANDBELOW(2);
     }
 
     if (initfile[0]){
@@ -1142,7 +1700,7 @@ void init(char initfile[], int initoptions)
         {
         if((clause[i][j] > 0) == atom[ABS(clause[i][j])])
           {
-              numtruelit[i]++;
+              NUMTRUELIT(i)++;
               thetruelit = clause[i][j];
 #ifdef _WATCH
               if (!truelit1)
@@ -1152,27 +1710,27 @@ void init(char initfile[], int initoptions)
 #endif            
           }
         }
-      if(numtruelit[i] == 0)
+      if(NUMTRUELIT(i) == 0)
         {
-        wherefalse[i] = numfalse;
+        WHEREFALSE(i) = numfalse;
         false[numfalse] = i;
         numfalse++;
         for(j = 0;j < size[i];j++){
-          makecount[ABS(clause[i][j])]++;
+          MAKECOUNT(ABS(clause[i][j]))++;
         }
         }
-      else if (numtruelit[i] == 1)
+      else if (NUMTRUELIT(i) == 1)
         {
-        breakcount[ABS(thetruelit)]++;
+        BREAKCOUNT(ABS(thetruelit))++;
 #ifdef _WATCH
-        watch1[i] = ABS(thetruelit);
+        WATCH1(i) = ABS(thetruelit);
 #endif
         }
 #ifdef _WATCH
-      else /*if (numtruelit[i] == 2)*/
+      else /*if (NUMTRUELIT(i) == 2)*/
         {
-          watch1[i] = ABS(truelit1);
-          watch2[i] = ABS(truelit2);
+          WATCH1(i) = ABS(truelit1);
+          WATCH2(i) = ABS(truelit2);
         }
 #endif
       }
@@ -1211,60 +1769,206 @@ save_false_clauses(long int lowbad)
       lowfalse[i] = false[i];
 }
 
+/* reads the formula and builds the occurrence lists */
 void initprob(void)
+{
+    char * buf;
+    size_t length;
+    double start;
+    double seconds;
+
+    start = wall_seconds();
+    if (genflag)
+      {
+      generate_formula(gen_N, gen_M, gen_K, gen_seed);
+      init_occurence();
+      seconds = wall_seconds() - start;
+      if (parseonly)
+        {
+        printf("numatom = %i, numclause = %i, numliterals = %i\n", numatom, numclause, numliterals);
+        printf("generation seconds = %f\n", seconds);
+        exit(0);
+        }
+      return;
+      }
+
+    buf = read_input(cnffile, &length);
+    if (length >= BCNF_HEADER && memcmp(buf, BCNF_MAGIC, 4) == 0)
+      parse_binary(buf, length);
+    else
+      {
+      parse_dimacs(buf, length);
+      /* the literals were copied, the text is not needed anymore */
+#if UNIX || OSX
+      if (cnffile[0]) munmap(buf, length);
+      else free(buf);
+#else
+      free(buf);
+#endif
+      }
+    init_occurence();
+    seconds = wall_seconds() - start;
+
+    if (parseonly)
+      {
+      printf("numatom = %i, numclause = %i, numliterals = %i\n", numatom, numclause, numliterals);
+      printf("parse seconds = %f\n", seconds);
+      printf("literals per second = %.4e\n", seconds > 0 ? numliterals / seconds : 0.0);
+      exit(0);
+      }
+}
+
+
+/* returns the whole input in memory, mapped if it is a file */
+char * read_input(char * filename, size_t * length)
+{
+    char * buf;
+    size_t capacity;
+    size_t nread;
+    FILE * infile;
+
+#if UNIX || OSX
+    if (filename[0])
+      {
+      int fd;
+      struct stat st;
+      if ((fd = open(filename, O_RDONLY)) < 0 || fstat(fd, &st) != 0)
+        {
+        fprintf(stderr, "Cannot open %s\n", filename);
+        exit(-1);
+        }
+      *length = st.st_size;
+      buf = (char *) mmap(NULL, *length > 0 ? *length : 1, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      close(fd);
+      if (buf == MAP_FAILED)
+        {
+        fprintf(stderr, "Cannot map %s\n", filename);
+        exit(-1);
+        }
+      madvise(buf, *length, MADV_SEQUENTIAL);
+      return buf;
+      }
+#endif
+
+    if (filename[0])
+      {
+      if ((infile = fopen(filename, "rb")) == NULL)
+        {
+        fprintf(stderr, "Cannot open %s\n", filename);
+        exit(-1);
+        }
+      }
+    else
+      infile = stdin;
+
+    capacity = 1 << 20;
+    *length = 0;
+    buf = (char *) malloc(capacity);
+    while (buf != NULL && (nread = fread(buf + *length, 1, capacity - *length, infile)) > 0)
+      {
+      *length += nread;
+      if (*length == capacity)
+        {
+        capacity *= 2;
+        buf = (char *) realloc(buf, capacity);
+        }
+      }
+    if (buf == NULL)
+      {
+      fprintf(stderr, "ERROR - not enough memory for the input\n");
+      exit(-1);
+      }
+    if (infile != stdin) fclose(infile);
+    return buf;
+}
+
+
+/* moves *pos past blanks and reads one integer, returns FALSE if there is none */
+static int next_int(char ** pos, char * end, int * value)
+{
+    char * p = *pos;
+    long v = 0;
+    int neg = FALSE;
+
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+    if (p < end && (*p == '-' || *p == '+'))
+      {
+      neg = (*p == '-');
+      p++;
+      }
+    if (p == end || *p < '0' || *p > '9') return FALSE;
+    while (p < end && *p >= '0' && *p <= '9')
+      v = 10 * v + (*p++ - '0');
+    *value = neg ? -v : v;
+    *pos = p;
+    return TRUE;
+}
+
+
+void parse_dimacs(char * buf, size_t length)
 {
     int i;
-    int j;
-    int lastc;
-    int nextc;
+    char * pos = buf;
+    char * end = buf + length;
+    int *litstore;
     int *storeptr;
-    int freestore;
+    long storesize;
+    long growth;
+    long numstored;
     int lit;
 
-    while ((lastc = getchar()) == 'c')
+    /* comment lines before the header */
+    while (pos < end && *pos == 'c')
       {
-      while ((nextc = getchar()) != EOF && nextc != '\n');
+      while (pos < end && *pos != '\n') pos++;
+      if (pos < end) pos++;
       }
-    ungetc(lastc,stdin);
-    if (scanf("p cnf %i %i",&numatom,&numclause) != 2)
+    if (pos == end || *pos != 'p')
       {
       fprintf(stderr,"Bad input file\n");
       exit(-1);
       }
-    if(numatom > MAXATOM)
+    pos++;
+    while (pos < end && (*pos == ' ' || *pos == '\t')) pos++;
+    if (end - pos < 3 || strncmp(pos, "cnf", 3) != 0)
       {
-      fprintf(stderr,"ERROR - too many atoms\n");
+      fprintf(stderr,"Bad input file\n");
+      exit(-1);
+      }
+    pos += 3;
+    if (!next_int(&pos, end, &numatom) || !next_int(&pos, end, &numclause))
+      {
+      fprintf(stderr,"Bad input file\n");
       exit(-1);
       }
 
-#ifdef DYNAMIC
-    clause = (int **) malloc(sizeof(int *)*(numclause+1));
+    alloc_formula();
     size = (int *) malloc(sizeof(int)*(numclause+1));
-    false = (int *) malloc(sizeof(int)*(numclause+1));
-    lowfalse = (int *) malloc(sizeof(int)*(numclause+1));
-    wherefalse = (int *) malloc(sizeof(int)*(numclause+1));
-    numtruelit = (int *) malloc(sizeof(int)*(numclause+1));
-#else
-    if(numclause > MAXCLAUSE)                     
-      {                                      
-      fprintf(stderr,"ERROR - too many clauses\n"); 
-      exit(-1);                              
-      }                                        
-#endif
-    freestore = 0;
+    /* the literal store starts with room for 3-SAT and grows as needed */
+    storesize = 3 * (long) numclause + MAXLENGTH;
+    litstore = (int *) malloc(sizeof(int)*storesize);
+    if (size == NULL || litstore == NULL)
+      {
+      fprintf(stderr,"ERROR - not enough memory for the formula\n");
+      exit(-1);
+      }
+
     numliterals = 0;
-    for(i = 0;i < 2*MAXATOM+1;i++)
-      numoccurence[i] = 0;
+    numstored = 0;
     for(i = 0;i < numclause;i++)
       {
       size[i] = -1;
-      if (freestore < MAXLENGTH)
+      if (storesize - numstored < MAXLENGTH)
         {
-        storeptr = (int *) malloc( sizeof(int) * STOREBLOCK );
-        freestore = STOREBLOCK;
-        fprintf(stderr,"allocating memory...\n");
+        growth = storesize < STOREBLOCK ? storesize : STOREBLOCK;
+        storesize += growth;
+        litstore = (int *) realloc(litstore, sizeof(int)*storesize);
+        if (litstore == NULL)
+          {
+              fprintf(stderr,"ERROR - not enough memory for the formula\n");
+              exit(-1);
+          }
         }
-      clause[i] = storeptr;
       do
         {
         size[i]++;
@@ -1273,50 +1977,354 @@ void initprob(void)
               printf("ERROR - clause too long\n");
               exit(-1);
           }
-        if (scanf("%i ",&lit) != 1)
+        if (!next_int(&pos, end, &lit))
           {
               fprintf(stderr, "Bad input file\n");
               exit(-1);
           }
         if(lit != 0)
           {
-              *(storeptr++) = lit; /* clause[i][size[i]] = j; */
-              freestore--;
+              if (ABS(lit) > numatom)
+                {
+                  fprintf(stderr, "Bad input file, literal %d out of range\n", lit);
+                  exit(-1);
+                }
+              litstore[numstored++] = lit;
               numliterals++;
-              numoccurence[lit+MAXATOM]++;
           }
         }
       while(lit != 0);
       }
-    if(size[0] == 0)
+    if(numclause == 0 || size[0] == 0)
       {
       fprintf(stderr,"ERROR - incorrect problem format or extraneous characters\n");
       exit(-1);
       }
 
-    for(i = 0;i < 2*MAXATOM+1;i++)
+    /* the store is trimmed to its exact size before the clauses point into it */
+    if (numliterals > 0)
+      litstore = (int *) realloc(litstore, sizeof(int)*numliterals);
+    storeptr = litstore;
+    for(i = 0;i < numclause;i++)
       {
-      if (freestore < numoccurence[i])
-        {
-        storeptr = (int *) malloc( sizeof(int) * STOREBLOCK );
-        freestore = STOREBLOCK;
-        fprintf(stderr,"allocating memory...\n");
-        }
-      occurence[i] = storeptr;
-      freestore -= numoccurence[i];
-      storeptr += numoccurence[i];
-      numoccurence[i] = 0;
+      clause[i] = storeptr;
+      storeptr += size[i];
+      }
+}
+
+
+/* the clauses point directly into the buffer, which is kept */
+void parse_binary(char * buf, size_t length)
+{
+    int i;
+    int j;
+    int * storeptr;
+    long long nlits;
+    long long total;
+
+    memcpy(&numatom, buf + 4, sizeof(int));
+    memcpy(&numclause, buf + 8, sizeof(int));
+    memcpy(&nlits, buf + 12, sizeof(long long));
+    if (numatom < 0 || numclause <= 0 || nlits < 0 || nlits > INT_MAX ||
+        length != BCNF_HEADER + sizeof(int) * ((size_t) numclause + (size_t) nlits))
+      {
+      fprintf(stderr,"Bad input file, wrong binary header\n");
+      exit(-1);
       }
+    numliterals = (int) nlits;
 
+    alloc_formula();
+    size = (int *) (buf + BCNF_HEADER);
+    storeptr = size + numclause;
+    total = 0;
     for(i = 0;i < numclause;i++)
       {
+      if (size[i] <= 0 || size[i] > MAXLENGTH)
+        {
+        fprintf(stderr,"Bad input file, clause %d has size %d\n", i, size[i]);
+        exit(-1);
+        }
+      total += size[i];
+      if (total > numliterals) break;
+      clause[i] = storeptr;
       for(j = 0;j < size[i];j++)
         {
-        occurence[clause[i][j]+MAXATOM]
-          [numoccurence[clause[i][j]+MAXATOM]] = i;
-        numoccurence[clause[i][j]+MAXATOM]++;
+        if (storeptr[j] == 0 || ABS(storeptr[j]) > numatom)
+          {
+          fprintf(stderr, "Bad input file, literal %d out of range\n", storeptr[j]);
+          exit(-1);
+          }
+        }
+      storeptr += size[i];
+      }
+    if (total != numliterals)
+      {
+      fprintf(stderr,"Bad input file, the clause sizes do not add up to numliterals\n");
+      exit(-1);
+      }
+}
+
+
+/* random K-SAT formula with M clauses of K distinct variables, as create_graph() */
+/* and PrintToInput() in Graph_to_CNF_input.cpp: the variables that do not appear */
+/* in any clause are removed, and the others are relabeled in the same order */
+void generate_formula(long N, long M, int K, unsigned long seed)
+{
+#ifdef _GSL
+    gsl_rng * r;
+    long he;
+    long var;
+    long counter;
+    long i;
+    int w;
+    int h;
+    int cond;
+    /* kept from one formula of the batch to the next */
+    static int * litstore = NULL;
+    static int * numfn = NULL;
+    static long * disc_before = NULL;
+    static long gen_cap_N = 0;
+    static long gen_cap_M = 0;
+
+    gsl_rng_env_setup();
+    r = gsl_rng_alloc(gsl_rng_default);
+    gsl_rng_set(r, seed);
+
+    /* the literals hold var+1 with the sign of the link until the relabeling */
+    if (N > gen_cap_N)
+      {
+      numfn = (int *) realloc(numfn, sizeof(int) * N);
+      disc_before = (long *) realloc(disc_before, sizeof(long) * N);
+      gen_cap_N = N;
+      }
+    if (M * K > gen_cap_M)
+      {
+      litstore = (int *) realloc(litstore, sizeof(int) * M * K);
+      size = (int *) realloc(size, sizeof(int) * (M+1));
+      gen_cap_M = M * K;
+      }
+    if (litstore == NULL || numfn == NULL || disc_before == NULL || size == NULL)
+      {
+      fprintf(stderr,"ERROR - not enough memory for the formula\n");
+      exit(-1);
+      }
+    memset(numfn, 0, sizeof(int) * N);
+
+    for (he = 0; he < M; he++)
+      {
+      w = 0;
+      while (w < K)
+        {
+        var = gsl_rng_uniform_int(r, N);
+        cond = TRUE;
+        for (h = 0; h < w && cond; h++)
+          if (ABS(litstore[he*K + h]) - 1 == var) cond = FALSE;
+        if (cond)
+          {
+          if (gsl_rng_uniform_pos(r) < 0.5)
+            litstore[he*K + w] = var + 1;
+          else
+            litstore[he*K + w] = -(var + 1);
+          numfn[var]++;
+          w++;
+          }
+        }
+      }
+
+    counter = 0;
+    for (i = 0; i < N; i++)
+      {
+      disc_before[i] = counter;
+      if (numfn[i] == 0) counter++;
+      }
+
+    numatom = N - counter;
+    numclause = M;
+    numliterals = M * K;
+    alloc_formula();
+    for (he = 0; he < M; he++)
+      {
+      size[he] = K;
+      clause[he] = litstore + he*K;
+      for (w = 0; w < K; w++)
+        {
+        var = ABS(litstore[he*K + w]) - 1;
+        litstore[he*K + w] = (litstore[he*K + w] > 0 ? 1 : -1) * (var - disc_before[var] + 1);
         }
       }
+
+    gsl_rng_free(r);
+#else
+    fprintf(stderr, "ERROR - -randomcnf needs GSL, compile without _NO_GSL\n");
+    exit(-1);
+#endif
+}
+
+
+/* arrays whose size is given by the header, reused by the next formula of a batch if it fits */
+void alloc_formula(void)
+{
+    static int atomcap = 0;
+    static int clausecap = 0;
+
+    if (numclause > clausecap)
+      {
+      clause = (int **) realloc(clause, sizeof(int *)*(numclause+1));
+      clausecap = numclause;
+      }
+    if (numatom > atomcap)
+      {
+      occ_start = (int *) realloc(occ_start, sizeof(int)*(2*numatom+2));
+      solution = (int *) realloc(solution, sizeof(int)*(numatom+1));
+      hamming_target = (int *) realloc(hamming_target, sizeof(int)*(numatom+1));
+      atomcap = numatom;
+      }
+    if (clause == NULL || occ_start == NULL ||
+        solution == NULL || hamming_target == NULL)
+      {
+      fprintf(stderr,"ERROR - not enough memory for the formula\n");
+      exit(-1);
+      }
+    memset(occ_start, 0, sizeof(int)*(2*numatom+2));
+}
+
+
+/* builds the occurrence lists and the size of the clause records */
+void init_occurence(void)
+{
+    int i;
+    int j;
+    int l;
+    int maxsize;
+    int *fill;
+    static int litcap = -1;
+
+    for(i = 0;i < numclause;i++)
+      for(j = 0;j < size[i];j++)
+        occ_start[clause[i][j]+numatom+1]++;
+    for(l = 0;l < 2*numatom+1;l++)
+      occ_start[l+1] += occ_start[l];
+
+    if (numliterals > litcap)
+      {
+      occ_list = (int *) realloc(occ_list, sizeof(int)*(numliterals+1));
+      litcap = numliterals;
+      }
+    fill = (int *) malloc(sizeof(int)*(2*numatom+1));
+    if (occ_list == NULL || fill == NULL)
+      {
+      fprintf(stderr,"ERROR - not enough memory for the formula\n");
+      exit(-1);
+      }
+    for(l = 0;l < 2*numatom+1;l++)
+      fill[l] = occ_start[l];
+    for(i = 0;i < numclause;i++)
+      for(j = 0;j < size[i];j++)
+        occ_list[fill[clause[i][j]+numatom]++] = i;
+    free(fill);
+
+    /* 5 fields and the literals, rounded up to a power of two or to a cache line */
+    maxsize = 0;
+    for(i = 0;i < numclause;i++)
+      if (size[i] > maxsize) maxsize = size[i];
+    clstride = 5 + maxsize;
+    if (clstride <= 16)
+      {
+      for (j = 1; j < clstride; j *= 2);
+      clstride = j;
+      }
+    else
+      clstride = 16 * ((clstride + 15) / 16);
+}
+
+/* allocates the state of a try in the calling thread. The arrays are kept */
+/* for the next formula of a batch, and only grow if it does not fit */
+void init_thread(int tid)
+{
+    int i;
+    int j;
+    static THREADLOCAL int atomcap = 0;
+    static THREADLOCAL long clreccap = 0;
+
+    if ((long) numclause * clstride > clreccap)
+      {
+      false = (int *) realloc(false, sizeof(int)*(numclause+1));
+      lowfalse = (int *) realloc(lowfalse, sizeof(int)*(numclause+1));
+      free(clrec);
+      clrec = (int *) calloc((long) numclause * clstride, sizeof(int));
+      clreccap = (long) numclause * clstride;
+      }
+    if (numatom > atomcap)
+      {
+      atom = (int *) realloc(atom, sizeof(int)*(numatom+1));
+      lowatom = (int *) realloc(lowatom, sizeof(int)*(numatom+1));
+      changed = (int *) realloc(changed, sizeof(int)*(numatom+1));
+      varcount = (int *) realloc(varcount, sizeof(int)*2*(numatom+1));
+      atomcap = numatom;
+      }
+    if (history_try == NULL)
+      history_try = (int *) calloc(numpoints, sizeof(int));
+    if (false == NULL || lowfalse == NULL || clrec == NULL ||
+        atom == NULL || lowatom == NULL || changed == NULL || varcount == NULL ||
+        history_try == NULL){
+    fprintf(stderr, "ERROR - not enough memory for thread %d\n", tid);
+    exit(-1);
+    }
+
+    /* the literals are copied once, the other fields are set by init() */
+    for(i = 0;i < numclause;i++)
+      {
+      CLSIZE(i) = size[i];
+      for(j = 0;j < size[i];j++)
+        CLLITS(i)[j] = clause[i][j];
+      }
+}
+
+/* seeds the random number generator of the calling thread for try thistry. The */
+/* stream only depends on seed and thistry, so the tries give the same results with */
+/* any number of threads, and runs with different seeds do not share any try */
+void seed_try(int thistry)
+{
+    unsigned long long key = ((unsigned long long) seed << 32) | (unsigned int) thistry;
+#ifdef _FASTRNG
+    seed_rng(key);
+#else
+    /* the 32 bits of the seed of random() are taken from splitmix64 of the key */
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+  #if UNIX
+    rand_data.state = NULL;
+    initstate_r((unsigned int) key, rand_statebuf, sizeof(rand_statebuf), &rand_data);
+  #else
+    srandom((unsigned int) key);
+  #endif
+#endif
+}
+
+/* copies pattern to name, with the first %d replaced by id */
+void instance_name(char * name, char * pattern, unsigned long id)
+{
+    char * pos = strstr(pattern, "%d");
+    if (pos == NULL)
+      strcpy(name, pattern);
+    else
+      sprintf(name, "%.*s%lu%s", (int) (pos - pattern), pattern, id, pos + 2);
+}
+
+/* probability that FMS accepts a move that breaks c clauses more than it makes, */
+/* for c up to the largest number of occurrences of a literal */
+void init_eta_pow(void)
+{
+    int i;
+    int maxocc = 0;
+
+    for (i = 0; i < 2*numatom+1; i++)
+      if (NUMOCCURENCE(i) > maxocc) maxocc = NUMOCCURENCE(i);
+    eta_pow = (double *) realloc(eta_pow, sizeof(double)*(maxocc+1));
+    eta_pow[0] = 1.0;
+    for (i = 1; i <= maxocc; i++)
+      eta_pow[i] = eta_pow[i-1] * numerator / denominator;
 }
 
 #ifdef _WATCH
@@ -1332,6 +2340,7 @@ void flipatom(int toflip)
     register int * litptr;
     int * occptr;
     register int v;
+    register int * rec;     /* record of the clause cli */
     /* printf("flipping %i\n", toflip); */
 
     if (toflip == NOVALUE){
@@ -1355,61 +2364,64 @@ void flipatom(int toflip)
       fprintf(hamming_fp, "%i %i\n", numflip, hamming_distance);
     }
     
-    numocc = numoccurence[MAXATOM-toenforce];
-    occptr = occurence[MAXATOM-toenforce];
+    numocc = NUMOCCURENCE(numatom-toenforce);
+    occptr = OCCURENCE(numatom-toenforce);
     for(i = 0; i < numocc ;i++)
       {
-      /* cli = occurence[MAXATOM-toenforce][i]; */
+      /* cli = OCCURENCE(numatom-toenforce)[i]; */
       cli = *(occptr++);
+      rec = CLREC(cli);
+      /* the record of the next clause is loaded while this one is updated */
+      if (i+1 < numocc) PREFETCH(CLREC(*occptr));
 
-      if (--numtruelit[cli] == 0){
+      if (--R_NUMTRUELIT(rec) == 0){
           false[numfalse] = cli;
-          wherefalse[cli] = numfalse;
+          R_WHEREFALSE(rec) = numfalse;
           numfalse++;
           /* Decrement toflip's breakcount */
-          breakcount[toflip]--;
+          BREAKCOUNT(toflip)--;
 
           if (makeflag){
         /* Increment the makecount of all vars in the clause */
-        sz = size[cli];
-        litptr = clause[cli];
+        sz = R_SIZE(rec);
+        litptr = R_LITS(rec);
         for (j=0; j<sz; j++){
-          /* lit = clause[cli][j]; */
+          /* lit = R_LITS(rec)[j]; */
           lit = *(litptr++);
-          makecount[ABS(lit)]++;
+          MAKECOUNT(ABS(lit))++;
         }
           }
       }
-      else if (numtruelit[cli] == 1){
-        if (watch1[cli] == toflip) {
-          assert(watch1[cli] != watch2[cli]);
-          watch1[cli] = watch2[cli];
+      else if (R_NUMTRUELIT(rec) == 1){
+        if (R_WATCH1(rec) == toflip) {
+          assert(R_WATCH1(rec) != R_WATCH2(rec));
+          R_WATCH1(rec) = R_WATCH2(rec);
         }
-        breakcount[watch1[cli]]++;
+        BREAKCOUNT(R_WATCH1(rec))++;
       }
-      else { /* numtruelit[cli] >= 2 */
-        if (watch1[cli] == toflip) {
-          /* find a true literal other than watch1[cli] and watch2[cli] */
-          sz = size[cli];
-          litptr = clause[cli];
+      else { /* R_NUMTRUELIT(rec) >= 2 */
+        if (R_WATCH1(rec) == toflip) {
+          /* find a true literal other than R_WATCH1(rec) and R_WATCH2(rec) */
+          sz = R_SIZE(rec);
+          litptr = R_LITS(rec);
           for (j=0; j<sz; j++) {
         lit = *(litptr++);
         v = ABS(lit);
-        if ((lit>0) == atom[v] && v != watch1[cli] && v != watch2[cli]) {
-            watch1[cli] = v;
+        if ((lit>0) == atom[v] && v != R_WATCH1(rec) && v != R_WATCH2(rec)) {
+            R_WATCH1(rec) = v;
             break;
         }
           }
         }
-        else if (watch2[cli] == toflip) {
-          /* find a true literal other than watch1[cli] and watch2[cli] */
-          sz = size[cli];
-          litptr = clause[cli];
+        else if (R_WATCH2(rec) == toflip) {
+          /* find a true literal other than R_WATCH1(rec) and R_WATCH2(rec) */
+          sz = R_SIZE(rec);
+          litptr = R_LITS(rec);
           for (j=0; j<sz; j++) {
         lit = *(litptr++);
         v =ABS(lit);
-        if ((lit>0) == atom[v] && v != watch1[cli] && v != watch2[cli]) {
-            watch2[cli] = v;
+        if ((lit>0) == atom[v] && v != R_WATCH1(rec) && v != R_WATCH2(rec)) {
+            R_WATCH2(rec) = v;
             break;
         }
           }
@@ -1417,37 +2429,40 @@ void flipatom(int toflip)
       }
       }
     
-    numocc = numoccurence[MAXATOM+toenforce];
-    occptr = occurence[MAXATOM+toenforce];
+    numocc = NUMOCCURENCE(numatom+toenforce);
+    occptr = OCCURENCE(numatom+toenforce);
     for(i = 0; i < numocc; i++)
       {
-      /* cli = occurence[MAXATOM+toenforce][i]; */
+      /* cli = OCCURENCE(numatom+toenforce)[i]; */
       cli = *(occptr++);
+      rec = CLREC(cli);
+      /* the record of the next clause is loaded while this one is updated */
+      if (i+1 < numocc) PREFETCH(CLREC(*occptr));
 
-      if (++numtruelit[cli] == 1){
+      if (++R_NUMTRUELIT(rec) == 1){
           numfalse--;
-          false[wherefalse[cli]] =
+          false[R_WHEREFALSE(rec)] =
         false[numfalse];
-          wherefalse[false[numfalse]] =
-        wherefalse[cli];
+          WHEREFALSE(false[numfalse]) =
+        R_WHEREFALSE(rec);
           /* Increment toflip's breakcount */
-          breakcount[toflip]++;
+          BREAKCOUNT(toflip)++;
 
           if (makeflag){
         /* Decrement the makecount of all vars in the clause */
-        sz = size[cli];
-        litptr = clause[cli];
+        sz = R_SIZE(rec);
+        litptr = R_LITS(rec);
         for (j=0; j<sz; j++){
-          /* lit = clause[cli][j]; */
+          /* lit = R_LITS(rec)[j]; */
           lit = *(litptr++);
-          makecount[ABS(lit)]--;
+          MAKECOUNT(ABS(lit))--;
         }
           }
-          watch1[cli] = toflip;
+          R_WATCH1(rec) = toflip;
       }
-      else if (numtruelit[cli] == 2){
-        watch2[cli] = toflip;
-        breakcount[watch1[cli]]--;
+      else if (R_NUMTRUELIT(rec) == 2){
+        R_WATCH2(rec) = toflip;
+        BREAKCOUNT(R_WATCH1(rec))--;
       }
       }
 }
@@ -1490,84 +2505,84 @@ void flipatom(int toflip)
       fprintf(hamming_fp, "%i %i\n", numflip, hamming_distance);
     }
     
-    numocc = numoccurence[MAXATOM-toenforce];
-    occptr = occurence[MAXATOM-toenforce];
+    numocc = NUMOCCURENCE(numatom-toenforce);
+    occptr = OCCURENCE(numatom-toenforce);
     for(i = 0; i < numocc ;i++)
       {
-      /* cli = occurence[MAXATOM-toenforce][i]; */
+      /* cli = OCCURENCE(numatom-toenforce)[i]; */
       cli = *(occptr++);
 
-      if (--numtruelit[cli] == 0){
+      if (--NUMTRUELIT(cli) == 0){
           false[numfalse] = cli;
-          wherefalse[cli] = numfalse;
+          WHEREFALSE(cli) = numfalse;
           numfalse++;
           /* Decrement toflip's breakcount */
-          breakcount[toflip]--;
+          BREAKCOUNT(toflip)--;
 
           if (makeflag){
         /* Increment the makecount of all vars in the clause */
-        sz = size[cli];
-        litptr = clause[cli];
+        sz = CLSIZE(cli);
+        litptr = CLLITS(cli);
         for (j=0; j<sz; j++){
-          /* lit = clause[cli][j]; */
+          /* lit = CLLITS(cli)[j]; */
           lit = *(litptr++);
-          makecount[ABS(lit)]++;
+          MAKECOUNT(ABS(lit))++;
         }
           }
       }
-      else if (numtruelit[cli] == 1){
+      else if (NUMTRUELIT(cli) == 1){
           /* Find the lit in this clause that makes it true, and inc its breakcount */
-          sz = size[cli];
-          litptr = clause[cli];
+          sz = CLSIZE(cli);
+          litptr = CLLITS(cli);
           for (j=0; j<sz; j++){
-          /* lit = clause[cli][j]; */
+          /* lit = CLLITS(cli)[j]; */
           lit = *(litptr++);
           if((lit > 0) == atom[ABS(lit)]){
-              breakcount[ABS(lit)]++;
+              BREAKCOUNT(ABS(lit))++;
               break;
           }
           }
       }
       }
     
-    numocc = numoccurence[MAXATOM+toenforce];
-    occptr = occurence[MAXATOM+toenforce];
+    numocc = NUMOCCURENCE(numatom+toenforce);
+    occptr = OCCURENCE(numatom+toenforce);
     for(i = 0; i < numocc; i++)
       {
-      /* cli = occurence[MAXATOM+toenforce][i]; */
+      /* cli = OCCURENCE(numatom+toenforce)[i]; */
       cli = *(occptr++);
 
-      if (++numtruelit[cli] == 1){
+      if (++NUMTRUELIT(cli) == 1){
           numfalse--;
-          false[wherefalse[cli]] =
+          false[WHEREFALSE(cli)] =
         false[numfalse];
-          wherefalse[false[numfalse]] =
-        wherefalse[cli];
+          WHEREFALSE(false[numfalse]) =
+        WHEREFALSE(cli);
           /* Increment toflip's breakcount */
-          breakcount[toflip]++;
+          BREAKCOUNT(toflip)++;
 
           if (makeflag){
         /* Decrement the makecount of all vars in the clause */
-        sz = size[cli];
-        litptr = clause[cli];
+        sz = CLSIZE(cli);
+        litptr = CLLITS(cli);
         for (j=0; j<sz; j++){
-          /* lit = clause[cli][j]; */
+          /* lit = CLLITS(cli)[j]; */
           lit = *(litptr++);
-          makecount[ABS(lit)]--;
+          MAKECOUNT(ABS(lit))--;
         }
           }
       }
-      else if (numtruelit[cli] == 2){
+      else if (NUMTRUELIT(cli) == 2){
           /* Find the lit in this clause other than toflip that makes it true,
          and decrement its breakcount */
-          sz = size[cli];
-          litptr = clause[cli];
+          sz = CLSIZE(cli);
+          litptr = CLLITS(cli);
           for (j=0; j<sz; j++){
-          /* lit = clause[cli][j]; */
+          /* lit = CLLITS(cli)[j]; */
           lit = *(litptr++);
           if( ((lit > 0) == atom[ABS(lit)]) &&
              (toflip != ABS(lit)) ){
-              breakcount[ABS(lit)]--;
+              BREAKCOUNT(ABS(lit))--;
               break;
           }
           }
@@ -1614,77 +2629,77 @@ void flipatom_watch1(int toflip)
       fprintf(hamming_fp, "%i %i\n", numflip, hamming_distance);
     }
     
-    numocc = numoccurence[MAXATOM-toenforce];
-    occptr = occurence[MAXATOM-toenforce];
+    numocc = NUMOCCURENCE(numatom-toenforce);
+    occptr = OCCURENCE(numatom-toenforce);
     for(i = 0; i < numocc ;i++)
       {
-      /* cli = occurence[MAXATOM-toenforce][i]; */
+      /* cli = OCCURENCE(numatom-toenforce)[i]; */
       cli = *(occptr++);
 
-      if (--numtruelit[cli] == 0){
+      if (--NUMTRUELIT(cli) == 0){
           false[numfalse] = cli;
-          wherefalse[cli] = numfalse;
+          WHEREFALSE(cli) = numfalse;
           numfalse++;
           /* Decrement toflip's breakcount */
-          breakcount[toflip]--;
+          BREAKCOUNT(toflip)--;
 
           if (makeflag){
         /* Increment the makecount of all vars in the clause */
-        sz = size[cli];
-        litptr = clause[cli];
+        sz = CLSIZE(cli);
+        litptr = CLLITS(cli);
         for (j=0; j<sz; j++){
-          /* lit = clause[cli][j]; */
+          /* lit = CLLITS(cli)[j]; */
           lit = *(litptr++);
-          makecount[ABS(lit)]++;
+          MAKECOUNT(ABS(lit))++;
         }
           }
       }
-      else if (numtruelit[cli] == 1){
+      else if (NUMTRUELIT(cli) == 1){
           /* Find the lit in this clause that makes it true, and inc its breakcount */
-          sz = size[cli];
-          litptr = clause[cli];
+          sz = CLSIZE(cli);
+          litptr = CLLITS(cli);
           for (j=0; j<sz; j++){
-          /* lit = clause[cli][j]; */
+          /* lit = CLLITS(cli)[j]; */
           lit = *(litptr++);
           if((lit > 0) == atom[ABS(lit)]){
-            watch1[cli] = ABS(lit);
-              breakcount[ABS(lit)]++;
+            WATCH1(cli) = ABS(lit);
+              BREAKCOUNT(ABS(lit))++;
               break;
           }
           }
       }
       }
     
-    numocc = numoccurence[MAXATOM+toenforce];
-    occptr = occurence[MAXATOM+toenforce];
+    numocc = NUMOCCURENCE(numatom+toenforce);
+    occptr = OCCURENCE(numatom+toenforce);
     for(i = 0; i < numocc; i++)
       {
-      /* cli = occurence[MAXATOM+toenforce][i]; */
+      /* cli = OCCURENCE(numatom+toenforce)[i]; */
       cli = *(occptr++);
 
-      if (++numtruelit[cli] == 1){
+      if (++NUMTRUELIT(cli) == 1){
           numfalse--;
-          false[wherefalse[cli]] =
+          false[WHEREFALSE(cli)] =
         false[numfalse];
-          wherefalse[false[numfalse]] =
-        wherefalse[cli];
+          WHEREFALSE(false[numfalse]) =
+        WHEREFALSE(cli);
           /* Increment toflip's breakcount */
-          breakcount[toflip]++;
-          watch1[cli] = toflip;
+          BREAKCOUNT(toflip)++;
+          WATCH1(cli) = toflip;
 
           if (makeflag){
         /* Decrement the makecount of all vars in the clause */
-        sz = size[cli];
-        litptr = clause[cli];
+        sz = CLSIZE(cli);
+        litptr = CLLITS(cli);
         for (j=0; j<sz; j++){
-          /* lit = clause[cli][j]; */
+          /* lit = CLLITS(cli)[j]; */
           lit = *(litptr++);
-          makecount[ABS(lit)]--;
+          MAKECOUNT(ABS(lit))--;
         }
           }
       }
-      else if (numtruelit[cli] == 2){
-        breakcount[watch1[cli]]--;
+      else if (NUMTRUELIT(cli) == 2){
+        BREAKCOUNT(WATCH1(cli))--;
       }
       }
 }
@@ -1699,8 +2714,8 @@ int pickrandom(void)
 {
     int tofix;
 
-    tofix = false[random()%numfalse];
-    return Var(tofix, random()%size[tofix]);
+    tofix = false[RANDBELOW(numfalse)];
+    return Var(tofix, RANDBELOW(CLSIZE(tofix)));
 }
 
 
@@ -1715,14 +2730,14 @@ int pickbest(void)
     register int bestvalue;
     register int var;
 
-    tofix = false[random()%numfalse];
-    clausesize = size[tofix];
+    tofix = false[RANDBELOW(numfalse)];
+    clausesize = CLSIZE(tofix);
     numbest = 0;
     bestvalue = BIG;
 
     for (i=0; i< clausesize; i++){
-      var = ABS(clause[tofix][i]);
-      numbreak = breakcount[var];
+      var = ABS(CLLITS(tofix)[i]);
+      numbreak = BREAKCOUNT(var);
       if (numbreak<=bestvalue){
     if (numbreak<bestvalue) numbest=0;
     bestvalue = numbreak;
@@ -1730,11 +2745,11 @@ int pickbest(void)
       }
     }
 
-    if (bestvalue>0 && (random()%denominator < numerator))
-      return ABS(clause[tofix][random()%clausesize]);
+    if (bestvalue>0 && (RANDBELOW(denominator) < numerator))
+      return ABS(CLLITS(tofix)[RANDBELOW(clausesize)]);
 
     if (numbest == 1) return best[0];
-    return best[random()%numbest];
+    return best[RANDBELOW(numbest)];
 }
 
 
@@ -1744,18 +2759,18 @@ int picknovelty(void)
   int youngest, youngest_birthdate, best, second_best, best_diff, second_best_diff;
   int tofix, clausesize, i;
 
-  tofix = false[random()%numfalse];
-  clausesize = size[tofix];  
+  tofix = false[RANDBELOW(numfalse)];
+  clausesize = CLSIZE(tofix);  
 
-  if (clausesize == 1) return ABS(clause[tofix][0]);
+  if (clausesize == 1) return ABS(CLLITS(tofix)[0]);
 
   youngest_birthdate = -1;
   best_diff = -BIG;
   second_best_diff = -BIG;
 
   for(i = 0; i < clausesize; i++){
-    var = ABS(clause[tofix][i]);
-    diff = makecount[var] - breakcount[var];
+    var = ABS(CLLITS(tofix)[i]);
+    diff = MAKECOUNT(var) - BREAKCOUNT(var);
     birthdate = changed[var];
     if (birthdate > youngest_birthdate){
       youngest_birthdate = birthdate;
@@ -1775,7 +2790,7 @@ int picknovelty(void)
     }
   }
   if (best != youngest) return best;
-  if ((random()%denominator < numerator)) return second_best;
+  if ((RANDBELOW(denominator) < numerator)) return second_best;
   return best;
 }
 
@@ -1786,19 +2801,19 @@ int pickrnovelty(void)
   int youngest, youngest_birthdate, best, second_best, best_diff, second_best_diff;
   int tofix, clausesize, i;
 
-  tofix = false[random()%numfalse];
-  clausesize = size[tofix];  
+  tofix = false[RANDBELOW(numfalse)];
+  clausesize = CLSIZE(tofix);  
 
-  if (clausesize == 1) return ABS(clause[tofix][0]);
-  if ((numflip % 100) == 0) return ABS(clause[tofix][random()%clausesize]);
+  if (clausesize == 1) return ABS(CLLITS(tofix)[0]);
+  if ((numflip % 100) == 0) return ABS(CLLITS(tofix)[RANDBELOW(clausesize)]);
 
   youngest_birthdate = -1;
   best_diff = -BIG;
   second_best_diff = -BIG;
 
   for(i = 0; i < clausesize; i++){
-    var = ABS(clause[tofix][i]);
-    diff = makecount[var] - breakcount[var];
+    var = ABS(CLLITS(tofix)[i]);
+    diff = MAKECOUNT(var) - BREAKCOUNT(var);
     birthdate = changed[var];
     if (birthdate > youngest_birthdate){
       youngest_birthdate = birthdate;
@@ -1828,16 +2843,16 @@ int pickrnovelty(void)
 
   if (numerator*2 < denominator && diffdiff > 1) return best;
   if (numerator*2 < denominator && diffdiff == 1){
-    if ((random()%denominator) < 2*numerator) return second_best;
+    if ((RANDBELOW(denominator)) < 2*numerator) return second_best;
     return best;
   }
   if (diffdiff == 1) return second_best;
 
 /*
-  if ((random()%denominator) < 2*(numerator-50)) return second_best;
+  if ((RANDBELOW(denominator)) < 2*(numerator-50)) return second_best;
 */
 
-  if ((random()%denominator) < 2*(numerator-(denominator/2))) return second_best;
+  if ((RANDBELOW(denominator)) < 2*(numerator-(denominator/2))) return second_best;
 
   return best;
 }
@@ -1872,21 +2887,21 @@ int picknoveltyplus(void)
   int youngest, youngest_birthdate, best, second_best, best_diff, second_best_diff;
   int tofix, clausesize, i;
 
-  tofix = false[random()%numfalse];
-  clausesize = size[tofix];  
+  tofix = false[RANDBELOW(numfalse)];
+  clausesize = CLSIZE(tofix);  
 
-  if (clausesize == 1) return ABS(clause[tofix][0]);
+  if (clausesize == 1) return ABS(CLLITS(tofix)[0]);
 
   /* hh: inserted modified loop breaker: */
-  if ((random()%wp_denominator < wp_numerator)) return ABS(clause[tofix][random()%clausesize]);
+  if ((RANDBELOW(wp_denominator) < wp_numerator)) return ABS(CLLITS(tofix)[RANDBELOW(clausesize)]);
 
   youngest_birthdate = -1;
   best_diff = -BIG;
   second_best_diff = -BIG;
 
   for(i = 0; i < clausesize; i++){
-    var = ABS(clause[tofix][i]);
-    diff = makecount[var] - breakcount[var];
+    var = ABS(CLLITS(tofix)[i]);
+    diff = MAKECOUNT(var) - BREAKCOUNT(var);
     birthdate = changed[var];
     if (birthdate > youngest_birthdate){
       youngest_birthdate = birthdate;
@@ -1906,7 +2921,7 @@ int picknoveltyplus(void)
     }
   }
   if (best != youngest) return best;
-  if ((random()%denominator < numerator)) return second_best;
+  if ((RANDBELOW(denominator) < numerator)) return second_best;
   return best;
 }
 
@@ -1917,16 +2932,16 @@ int pickrnoveltyplus(void)
   int youngest, youngest_birthdate, best, second_best, best_diff, second_best_diff;
   int tofix, clausesize, i;
 
-  tofix = false[random()%numfalse];
-  clausesize = size[tofix];  
+  tofix = false[RANDBELOW(numfalse)];
+  clausesize = CLSIZE(tofix);  
 
-  if (clausesize == 1) return ABS(clause[tofix][0]);
+  if (clausesize == 1) return ABS(CLLITS(tofix)[0]);
 
 /* hh: modified loop breaker: */
-  if ((random()%wp_denominator < wp_numerator)) return ABS(clause[tofix][random()%clausesize]);
+  if ((RANDBELOW(wp_denominator) < wp_numerator)) return ABS(CLLITS(tofix)[RANDBELOW(clausesize)]);
 
   /*
-  if ((numflip % 100) == 0) return ABS(clause[tofix][random()%clausesize]);
+  if ((numflip % 100) == 0) return ABS(CLLITS(tofix)[RANDBELOW(clausesize)]);
   */
 
   youngest_birthdate = -1;
@@ -1934,8 +2949,8 @@ int pickrnoveltyplus(void)
   second_best_diff = -BIG;
 
   for(i = 0; i < clausesize; i++){
-    var = ABS(clause[tofix][i]);
-    diff = makecount[var] - breakcount[var];
+    var = ABS(CLLITS(tofix)[i]);
+    diff = MAKECOUNT(var) - BREAKCOUNT(var);
     birthdate = changed[var];
     if (birthdate > youngest_birthdate){
       youngest_birthdate = birthdate;
@@ -1965,16 +2980,16 @@ int pickrnoveltyplus(void)
 
   if (numerator*2 < denominator && diffdiff > 1) return best;
   if (numerator*2 < denominator && diffdiff == 1){
-    if ((random()%denominator) < 2*numerator) return second_best;
+    if ((RANDBELOW(denominator)) < 2*numerator) return second_best;
     return best;
   }
   if (diffdiff == 1) return second_best;
 
 /*
-  if ((random()%denominator) < 2*(numerator-50)) return second_best;
+  if ((RANDBELOW(denominator)) < 2*(numerator-50)) return second_best;
 */
 
-  if ((random()%denominator) < 2*(numerator-(denominator/2))) return second_best;
+  if ((RANDBELOW(denominator)) < 2*(numerator-(denominator/2))) return second_best;
 
   return best;
 
@@ -1993,15 +3008,15 @@ int picktabu(void)
     int bestvalue;      /* best value so far */
     int noisypick;
 
-    tofix = false[random()%numfalse];
-    clausesize = size[tofix];
+    tofix = false[RANDBELOW(numfalse)];
+    clausesize = CLSIZE(tofix);
     for(i = 0;i < clausesize;i++)
-    numbreak[i] = breakcount[ABS(clause[tofix][i])];
+    numbreak[i] = BREAKCOUNT(ABS(CLLITS(tofix)[i]));
 
     numbest = 0;
     bestvalue = BIG;
 
-    noisypick = (numerator > 0 && random()%denominator < numerator); 
+    noisypick = (numerator > 0 && RANDBELOW(denominator) < numerator); 
     for (i=0; i < clausesize; i++) {
     if (numbreak[i] == 0) {
         if (bestvalue > 0) {
@@ -2010,7 +3025,7 @@ int picktabu(void)
         }
         best[numbest++] = i;
     }
-    else if (tabu_length < numflip - changed[ABS(clause[tofix][i])]) {
+    else if (tabu_length < numflip - changed[ABS(CLLITS(tofix)[i])]) {
         if (noisypick && bestvalue > 0) { 
         best[numbest++] = i; 
         }
@@ -2027,7 +3042,7 @@ int picktabu(void)
     }
     if (numbest == 0) return NOVALUE;
     if (numbest == 1) return Var(tofix, best[0]);
-    return (Var(tofix, best[random()%numbest]));
+    return (Var(tofix, best[RANDBELOW(numbest)]));
 }
 
 
@@ -2038,17 +3053,21 @@ int pickFMS(void)    /*  *******   FMS  ************ */
     int change;
     register int var;
 
-    tofix = false[random()%numfalse];
-    clausesize = size[tofix];
+    tofix = false[RANDBELOW(numfalse)];
+    clausesize = CLSIZE(tofix);
 
-    var = ABS(clause[tofix][random()%clausesize]);
-    change = breakcount[var] - makecount[var];
+    var = ABS(CLLITS(tofix)[RANDBELOW(clausesize)]);
+    change = BREAKCOUNT(var) - MAKECOUNT(var);
 
+#ifdef _FASTRNG
+    if (change > 0 && rand_uniform() >= eta_pow[change])  var = -1;
+#else
     while (change > 0) {
-      if (random()%denominator >= numerator)  break;
+      if (RANDBELOW(denominator) >= numerator)  break;
       change--;
     }
     if (change > 0)  var = -1;
+#endif
 
     return var;
 }
@@ -2060,13 +3079,13 @@ int pickASAT(void)    /*  *******   ASAT  ************ */
     int clausesize;
     register int var;
 
-    tofix = false[random()%numfalse];
-    clausesize = size[tofix];
+    tofix = false[RANDBELOW(numfalse)];
+    clausesize = CLSIZE(tofix);
 
-    var = ABS(clause[tofix][random()%clausesize]);
+    var = ABS(CLLITS(tofix)[RANDBELOW(clausesize)]);
 
-    if (breakcount[var] - makecount[var] > 0)
-      if (random()%denominator >= numerator)  
+    if (BREAKCOUNT(var) - MAKECOUNT(var) > 0)
+      if (RANDBELOW(denominator) >= numerator)  
     var = -1;
 
     return var;
@@ -2083,35 +3102,35 @@ int pickchain(void)    /*  *******   Chain  ************ */
     register int var;
 
     if (varChain < 0) {
-      tofix = false[random()%numfalse];
-      clausesize = size[tofix];
-      varChain = ABS(clause[tofix][random()%clausesize]);
+      tofix = false[RANDBELOW(numfalse)];
+      clausesize = CLSIZE(tofix);
+      varChain = ABS(CLLITS(tofix)[RANDBELOW(clausesize)]);
     }
     var = varChain;
-    change = breakcount[var] - makecount[var];
-    if ((change > 0) ? TRUE : ((change == 0) ? FALSE : (random()%denominator >= numerator)))
+    change = BREAKCOUNT(var) - MAKECOUNT(var);
+    if ((change > 0) ? TRUE : ((change == 0) ? FALSE : (RANDBELOW(denominator) >= numerator)))
       var = -1;
-    if ((change <= 0) ? TRUE : (random()%denominator < numerator))
+    if ((change <= 0) ? TRUE : (RANDBELOW(denominator) < numerator))
       varChain = -1;
     else {
       // next neighbor
-      liter = (atom[varChain] ? varChain : -varChain) + MAXATOM;
-      count = breakcount[varChain];
-      if (count > 1)  count = (random()%count)+1;
-      oct = numoccurence[liter];
+      liter = (atom[varChain] ? varChain : -varChain) + numatom;
+      count = BREAKCOUNT(varChain);
+      if (count > 1)  count = (RANDBELOW(count))+1;
+      oct = NUMOCCURENCE(liter);
       for (ci=0; ci<oct; ci++)
-    if (numtruelit[occurence[liter][ci]] == 1)
+    if (NUMTRUELIT(OCCURENCE(liter)[ci]) == 1)
       if (--count == 0)  break;
-      cli = occurence[liter][ci];
-      clausesize = size[cli];
+      cli = OCCURENCE(liter)[ci];
+      clausesize = CLSIZE(cli);
       if (clausesize == 1)  varChain = -1;
       else {
-    liter = liter - MAXATOM;
-    ci = random()%(clausesize-1);
+    liter = liter - numatom;
+    ci = RANDBELOW(clausesize-1);
     for (ki=0; ki<clausesize; ki++)
-      if (clause[cli][ki] != liter)
+      if (CLLITS(cli)[ki] != liter)
         if (ci-- == 0)  break;
-    varChain = ABS(clause[cli][ki]);
+    varChain = ABS(CLLITS(cli)[ki]);
       }
     }
 
@@ -2144,6 +3163,19 @@ int countunsat(void)
     }
 
 
+/* wall clock time, it includes the time spent reading the input */
+double wall_seconds(void)
+{
+#if UNIX || OSX
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec + 1e-6 * now.tv_usec;
+#else
+    return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+
 double elapsed_seconds(void) 
 { 
     double answer;
@@ -2249,7 +3281,7 @@ save_solution(void)
 
 /* Average whiteness depth (AWD) of the current assignment
    (if negative, gives the proportion of non-white variables) */
-/* (uses arrays atom[] and numtruelit[] for temporary bookkeeping) */
+/* (uses arrays atom[] and NUMTRUELIT() for temporary bookkeeping) */
 double
 whitening(void)
 {
@@ -2261,10 +3293,10 @@ whitening(void)
       prevct = whitect;
       for (vi=1; vi<=numatom; vi++)
         if (atom[vi] >= 0) {   /* if variable is non-white */
-      liter = (atom[vi] ? vi : -vi) + MAXATOM;
-      oct = numoccurence[liter];
-      clptr = occurence[liter];
-      for (ci=0; ci<oct; ci++)  if (numtruelit[clptr[ci]] == 1)  break;
+      liter = (atom[vi] ? vi : -vi) + numatom;
+      oct = NUMOCCURENCE(liter);
+      clptr = OCCURENCE(liter);
+      for (ci=0; ci<oct; ci++)  if (NUMTRUELIT(clptr[ci]) == 1)  break;
       if (ci == oct) {
         whitect++;
         atom[vi] -= 2;
@@ -2273,17 +3305,17 @@ whitening(void)
       depthsum += (whitect - prevct) * (double)depth;
       if ((whitect == numatom) || (whitect == prevct))  break;
       for (cli=0; cli<numclause; cli++)
-    if (numtruelit[cli] == 1) {  /* if clause is non-white */
-      for (ki=0; ki<size[cli]; ki++) 
-        if (atom[ABS(clause[cli][ki])] < 0)  break;
-      if (ki < size[cli])  numtruelit[cli] = -1;   /* clause becomes white */
+    if (NUMTRUELIT(cli) == 1) {  /* if clause is non-white */
+      for (ki=0; ki<CLSIZE(cli); ki++) 
+        if (atom[ABS(CLLITS(cli)[ki])] < 0)  break;
+      if (ki < CLSIZE(cli))  NUMTRUELIT(cli) = -1;   /* clause becomes white */
     }
     }
 
     if (whitect < numatom)  depthsum = -(numatom - whitect);   /* if not completely white */
 
     for (vi=1; vi<=numatom; vi++)  if (atom[vi] < 0)  atom[vi] += 2;
-    for (cli=0; cli<numclause; cli++)  if (numtruelit[cli] == -1)   numtruelit[cli] = 1;
+    for (cli=0; cli<numclause; cli++)  if (NUMTRUELIT(cli) == -1)   NUMTRUELIT(cli) = 1;
 
     return depthsum / numatom;
 }